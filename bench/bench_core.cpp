@@ -0,0 +1,449 @@
+// Micro/macro benchmarks for the core library. Results are written as one
+// JSON document so runs can be compared between releases.
+//
+//   bench_core [--quick] [--filter=<substring>] [--out=<file.json>]
+//   bench_core --budgets
+//
+// Each benchmark repeats its body until it has run for a minimum time and
+// reports the mean time per operation. Builds with SLIDESHOW_ALLOC_COUNTING
+// also report heap allocations per operation, and --budgets checks the hot
+// paths against fixed allocation budgets (exit status 1 on a regression).
+
+#include "AllocCounter.hpp"
+#include "CommandParser.hpp"
+#include "DeckGenerator.hpp"
+#include "ICommand.hpp"
+#include "Json.hpp"
+#include "Log.hpp"
+#include "PPTXSerializer.hpp"
+#include "RecordWriter.hpp"
+#include "Session.hpp"
+#include "Tokenizer.hpp"
+#include "lodepng.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result
+{
+    std::string name;
+    long long iterations = 0;
+    double totalSec = 0.0;
+    uint64_t allocs = 0;
+    uint64_t allocBytes = 0;
+};
+
+struct Options
+{
+    bool quick = false;
+    std::string filter;
+    std::string outFile;
+    bool budgets = false;
+};
+
+Options opts;
+std::vector<Result> results;
+
+// Runs `body` (one operation per call) until `minSec` has elapsed.
+// `setup`, if given, runs before each call and is not timed.
+void bench(const std::string& name, const std::function<void()>& body,
+           const std::function<void()>& setup = nullptr)
+{
+    if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos) return;
+
+    const double minSec = opts.quick ? 0.05 : 0.3;
+    Result r;
+    r.name = name;
+    while (r.totalSec < minSec) {
+        if (setup) setup();
+        const alloc::Scope scope;
+        const auto t0 = Clock::now();
+        body();
+        r.totalSec += std::chrono::duration<double>(Clock::now() - t0).count();
+        const alloc::Counts c = scope.counts();
+        r.allocs += c.allocs;
+        r.allocBytes += c.bytes;
+        ++r.iterations;
+    }
+    std::fprintf(stderr, "%-40s %12.0f ns/op  (%lld iterations)", name.c_str(),
+                 r.totalSec * 1e9 / double(r.iterations), r.iterations);
+    if (alloc::enabled()) std::fprintf(stderr, "  %10.1f allocs/op", double(r.allocs) / double(r.iterations));
+    std::fprintf(stderr, "\n");
+    results.push_back(std::move(r));
+}
+
+// Commands report through std::cout; keep that out of the measurements.
+class MuteCout
+{
+public:
+    MuteCout() : old_(std::cout.rdbuf(sink_.rdbuf())) {}
+    ~MuteCout() { std::cout.rdbuf(old_); }
+    void drain() { sink_.str(std::string()); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf* old_;
+};
+
+std::vector<uint8_t> makePng(unsigned w, unsigned h, uint32_t seed)
+{
+    std::vector<unsigned char> rgba(size_t(w) * h * 4);
+    for (unsigned y = 0; y < h; ++y)
+        for (unsigned x = 0; x < w; ++x) {
+            unsigned char* p = &rgba[(size_t(y) * w + x) * 4];
+            p[0] = static_cast<unsigned char>(x + seed);
+            p[1] = static_cast<unsigned char>(y ^ (seed >> 8));
+            p[2] = static_cast<unsigned char>((x * y) + seed * 7);
+            p[3] = 255;
+        }
+    std::vector<unsigned char> png;
+    lodepng::encode(png, rgba, w, h);
+    return std::vector<uint8_t>(png.begin(), png.end());
+}
+
+SlideShow makeDeck(size_t slides, size_t shapes, size_t images, uint32_t seed)
+{
+    DeckSpec spec;
+    spec.name = "bench_deck.pptx";
+    spec.slides = slides;
+    spec.shapesPerSlide = shapes;
+    spec.images = images;
+    spec.duplicateRatio = 0.25;
+    spec.seed = seed;
+    return generateDeck(spec);
+}
+
+void loadDeck(Session& session, SlideShow deck)
+{
+    std::vector<SlideShow> shows;
+    shows.push_back(std::move(deck));
+    session.replacePresentations(std::move(shows), {}, 0);
+    session.getTextIndex().markStale();
+}
+
+std::unique_ptr<ICommand> parseLine(const std::string& line, Session& session)
+{
+    std::istringstream in(line);
+    return CommandParser::parse(in, session);
+}
+
+// Parses and executes one command line, as the CLI loop does.
+void run(Session& session, const std::string& line)
+{
+    if (auto cmd = parseLine(line, session)) cmd->execute();
+    session.rebuildUiIndex();
+}
+
+void benchTokenizer()
+{
+    const std::string shortLine = "move shape 3 120 240";
+    const std::string longLine =
+        "add rect 10 20 300 120 \"A fairly long quoted title with several words in it\" "
+        "and some trailing unquoted words 1 2 3 4 5 6 7 8";
+    bench("tokenizer/short", [&] { (void)Tokenizer::tokenizeCommandLine(shortLine); });
+    bench("tokenizer/long", [&] { (void)Tokenizer::tokenizeCommandLine(longLine); });
+}
+
+void benchLogging()
+{
+    MuteCout mute;
+    long long n = 0;
+    auto drain = [&] {
+        if (++n % 10000 == 0) mute.drain();
+    };
+    bench("log/info_line", [&] { info() << "Moved shape " << 7 << " to (" << 120 << "," << 240 << ")\n"; }, drain);
+    logging::setMinLevel(logging::Level::Error);
+    bench("log/info_line_filtered", [&] { info() << "Moved shape " << 7 << " to (" << 120 << "," << 240 << ")\n"; });
+    logging::setMinLevel(logging::Level::Info);
+}
+
+void benchParser()
+{
+    Session session;
+    loadDeck(session, makeDeck(1, 0, 0, 1));
+    MuteCout mute;
+    bench("parse/add_rect", [&] { (void)parseLine("add rect 10 10 100 50 \"Title\"", session); });
+    bench("parse/move_shape", [&] { (void)parseLine("move shape 1 50 60", session); });
+    bench("parse/find_shapes",
+          [&] { (void)parseLine("find shapes where text~\"rev\" in all slides", session); });
+}
+
+void benchShapeCommands()
+{
+    const size_t shapesOnSlide = 50;
+    Session session;
+    MuteCout mute;
+
+    auto fresh = [&] {
+        loadDeck(session, makeDeck(1, shapesOnSlide, 0, 2));
+        mute.drain();
+    };
+    fresh();
+
+    // Commands that add shapes reset the slide now and then so it does not
+    // grow without bound.
+    long long added = 0;
+    auto bounded = [&] {
+        if (++added % 1000 == 0) fresh();
+    };
+
+    bench("cmd/add_rect", [&] { run(session, "add rect 10 10 100 50 \"Title\""); }, bounded);
+    bench("cmd/add_ellipse", [&] { run(session, "add ellipse 10 10 100 50 \"Oval\""); }, bounded);
+    bench("cmd/add_text", [&] { run(session, "add text 10 10 Hello world"); }, bounded);
+    bench("cmd/duplicate_shape", [&] { run(session, "duplicate shape 1 5 5"); }, bounded);
+
+    fresh();
+    bench("cmd/move_shape", [&] { run(session, "move shape 7 120 240"); });
+    bench("cmd/resize_shape", [&] { run(session, "resize shape 7 200 100"); });
+    bench("cmd/text_shape", [&] { run(session, "text shape 7 Updated text for the shape"); });
+    bench("cmd/list_shapes", [&] { run(session, "list shapes"); mute.drain(); });
+    setOutputFormat(OutputFormat::Json);
+    bench("cmd/list_shapes/json", [&] { run(session, "list shapes"); mute.drain(); });
+    setOutputFormat(OutputFormat::Tsv);
+    bench("cmd/list_shapes/tsv", [&] { run(session, "list shapes"); mute.drain(); });
+    setOutputFormat(OutputFormat::Text);
+
+    bench("cmd/remove_shape", [&] { run(session, "remove shape 1"); }, [&] {
+        if (session.getCurrentSlideshow().currentSlide().getShapes().empty()) fresh();
+    });
+
+    loadDeck(session, makeDeck(500, 20, 0, 3));
+    bench("index/rebuild/500x20", [&] { session.findText("quarterly"); },
+          [&] { session.getTextIndex().invalidate(); });
+    // An undo restores shapes the index already holds; only the edited
+    // one is re-indexed.
+    bench("index/after_undo/500x20", [&] { session.findText("quarterly"); }, [&] {
+        session.snapshot();
+        run(session, "text shape 1 Something else entirely");
+        session.undo();
+    });
+    bench("cmd/find_shapes/500x20", [&] {
+        run(session, "find shapes where text~\"quarterly revenue\" in all slides");
+        mute.drain();
+    });
+}
+
+void benchUndo()
+{
+    for (size_t slides : {10u, 100u, 1000u}) {
+        if (opts.quick && slides > 100) break;
+        Session session;
+        loadDeck(session, makeDeck(slides, 20, 0, 4));
+        const std::string sz = std::to_string(slides) + "x20";
+
+        // Popping each snapshot outside the timed region keeps the history
+        // one entry deep, so every iteration copies the same deck into the
+        // same stack.
+        bench("session/snapshot/" + sz, [&] { session.snapshot(); }, [&] { session.undo(); });
+
+        // Alternate so both stacks stay non-empty.
+        bool back = true;
+        bench("session/undo_redo/" + sz, [&] {
+            if (back) session.undo();
+            else session.redo();
+            back = !back;
+        });
+    }
+}
+
+void benchSerializer()
+{
+    const std::string path = "bench_core_tmp.pptx";
+    for (size_t slides : {10u, 100u, 1000u}) {
+        if (opts.quick && slides > 100) break;
+        std::vector<SlideShow> shows{makeDeck(slides, 20, slides / 10, 5)};
+        const std::vector<std::string> order{shows[0].getFilename()};
+        const std::string sz = std::to_string(slides) + "x20";
+
+        bench("serializer/save/" + sz, [&] { PPTXSerializer::save(shows, order, path); });
+
+        std::vector<SlideShow> loaded;
+        PresentationIndex index;
+        std::vector<std::string> loadedOrder;
+        size_t current = 0;
+        bench("serializer/load/" + sz,
+              [&] { PPTXSerializer::load(loaded, index, loadedOrder, current, path); });
+    }
+    std::remove(path.c_str());
+}
+
+void benchImageImport()
+{
+    const std::string path = "bench_core_tmp.png";
+    {
+        const std::vector<uint8_t> png = makePng(512, 512, 42);
+        std::ofstream f(path, std::ios::binary);
+        f.write(reinterpret_cast<const char*>(png.data()), std::streamsize(png.size()));
+    }
+
+    Session session;
+    loadDeck(session, makeDeck(1, 0, 0, 6));
+    MuteCout mute;
+    long long added = 0;
+    bench("image/import/512x512", [&] { run(session, "add image 10 10 " + path); }, [&] {
+        if (++added % 50 == 0) loadDeck(session, makeDeck(1, 0, 0, 6));
+        mute.drain();
+    });
+    std::remove(path.c_str());
+}
+
+// --- Allocation budgets ---------------------------------------------------
+//
+// Allocation counts are deterministic for a given input, so each budget is
+// the current count plus a little slack. Raise one only together with the
+// change that needs it.
+
+int budgetFailures = 0;
+
+// Runs `body` a few times (after one warm-up call) and checks the largest
+// per-call allocation count against `maxAllocs`. `body` returns false if
+// the operation failed; a failing operation allocates less than a working
+// one, so that counts as exceeding the budget.
+void budget(const std::string& name, uint64_t maxAllocs, const std::function<bool()>& body,
+            const std::function<void()>& setup = nullptr)
+{
+    uint64_t worst = 0, bytes = 0;
+    bool failed = false;
+    for (int i = 0; i < 6; ++i) {
+        if (setup) setup();
+        const alloc::Scope scope;
+        if (!body()) failed = true;
+        const alloc::Counts c = scope.counts();
+        if (i == 0) continue;
+        if (c.allocs > worst) {
+            worst = c.allocs;
+            bytes = c.bytes;
+        }
+    }
+    const bool ok = !failed && worst <= maxAllocs;
+    if (!ok) ++budgetFailures;
+    std::fprintf(stderr, "%-36s %8llu allocs %12llu bytes   budget %8llu  %s\n", name.c_str(),
+                 static_cast<unsigned long long>(worst), static_cast<unsigned long long>(bytes),
+                 static_cast<unsigned long long>(maxAllocs),
+                 failed ? "FAILED" : ok ? "ok" : "OVER BUDGET");
+}
+
+int checkBudgets()
+{
+    if (!alloc::enabled()) {
+        std::fprintf(stderr, "--budgets needs a build with -DSLIDESHOW_ALLOC_COUNTING=ON\n");
+        return 2;
+    }
+
+    const std::string shortLine = "move shape 3 120 240";
+    const std::string longLine =
+        "add rect 10 20 300 120 \"A fairly long quoted title with several words in it\" "
+        "and some trailing unquoted words 1 2 3 4 5 6 7 8";
+    budget("tokenize/short", 5, [&] { return !Tokenizer::tokenizeCommandLine(shortLine).empty(); });
+    budget("tokenize/long", 8, [&] { return !Tokenizer::tokenizeCommandLine(longLine).empty(); });
+
+    Session session;
+    loadDeck(session, makeDeck(1, 50, 0, 2));
+    MuteCout mute;
+    budget("parse/move_shape", 13, [&] { return parseLine(shortLine, session) != nullptr; });
+
+    // Execution alone (the caller takes the undo snapshot): moving a shape
+    // edits it in place and should not allocate.
+    std::unique_ptr<ICommand> cmd;
+    budget("execute/move_shape", 2, [&] {
+        const size_t errors = logging::errorCount();
+        cmd->execute();
+        return logging::errorCount() == errors;
+    }, [&] {
+        cmd = parseLine(shortLine, session);
+        mute.drain();
+    });
+
+    const std::string path = "bench_core_budget.pptx";
+    std::vector<SlideShow> shows{makeDeck(100, 20, 10, 5)};
+    const std::vector<std::string> order{shows[0].getFilename()};
+    budget("save/100x20", 4700, [&] { return PPTXSerializer::save(shows, order, path); });
+
+    std::vector<SlideShow> loaded;
+    PresentationIndex index;
+    std::vector<std::string> loadedOrder;
+    size_t current = 0;
+    budget("load/100x20", 33000,
+           [&] { return PPTXSerializer::load(loaded, index, loadedOrder, current, path); });
+    std::remove(path.c_str());
+
+    if (budgetFailures) std::fprintf(stderr, "%d allocation budget(s) exceeded\n", budgetFailures);
+    return budgetFailures ? 1 : 0;
+}
+
+std::string toJson()
+{
+    std::string out = "{\"suite\":\"bench_core\",\"quick\":";
+    out += opts.quick ? "true" : "false";
+    out += ",\"results\":[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        if (i) out += ',';
+        out += "{\"name\":";
+        json::appendString(out, r.name);
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), ",\"iterations\":%lld,\"total_s\":%.6f,\"ns_per_op\":%.1f}",
+                      r.iterations, r.totalSec, r.totalSec * 1e9 / double(r.iterations));
+        out += buf;
+        if (alloc::enabled()) {
+            out.pop_back();
+            std::snprintf(buf, sizeof(buf), ",\"allocs_per_op\":%.1f,\"alloc_bytes_per_op\":%.1f}",
+                          double(r.allocs) / double(r.iterations), double(r.allocBytes) / double(r.iterations));
+            out += buf;
+        }
+    }
+    out += "]}\n";
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--quick") opts.quick = true;
+        else if (a.rfind("--filter=", 0) == 0) opts.filter = a.substr(9);
+        else if (a.rfind("--out=", 0) == 0) opts.outFile = a.substr(6);
+        else if (a == "--budgets") opts.budgets = true;
+        else {
+            std::fprintf(stderr, "usage: bench_core [--quick] [--filter=<substring>] [--out=<file.json>]\n"
+                                 "       bench_core --budgets\n");
+            return 2;
+        }
+    }
+    if (opts.budgets) return checkBudgets();
+
+    benchTokenizer();
+    benchLogging();
+    benchParser();
+    benchShapeCommands();
+    benchUndo();
+    benchSerializer();
+    benchImageImport();
+
+    const std::string report = toJson();
+    if (opts.outFile.empty()) {
+        std::fwrite(report.data(), 1, report.size(), stdout);
+    } else {
+        std::ofstream f(opts.outFile, std::ios::binary);
+        f << report;
+        if (!f) {
+            std::fprintf(stderr, "Failed to write %s\n", opts.outFile.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Throughput of the JSON-RPC server (SlideShowCLI --serve) against a local
+// stub client. The server runs on a thread of this process; each client is
+// a plain blocking Unix-socket connection that pipelines requests.
+//
+//   bench_rpc [requests-per-client] [clients] [pipeline-depth]
+
+#include "RpcServer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+int connectTo(const std::string& path)
+{
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ::close(fd);
+    return -1;
+}
+
+bool sendAll(int fd, const std::string& s)
+{
+    size_t off = 0;
+    while (off < s.size()) {
+        const ssize_t n = ::send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Reads until `lines` newline-terminated responses have arrived.
+bool readLines(int fd, std::string& buf, int lines)
+{
+    char tmp[64 * 1024];
+    while (lines > 0) {
+        size_t nl;
+        while (lines > 0 && (nl = buf.find('\n')) != std::string::npos) {
+            buf.erase(0, nl + 1);
+            --lines;
+        }
+        if (lines == 0) break;
+        const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+        if (n <= 0) return false;
+        buf.append(tmp, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+// One client: sets up a deck, then alternates a mutating and a read-only
+// command. Every move takes an undo snapshot; the server's per-session
+// history limit is what keeps memory flat over a long run.
+bool runClient(const std::string& path, int requests, int depth)
+{
+    const int fd = connectTo(path);
+    if (fd < 0) return false;
+
+    std::string buf;
+    const std::string setup =
+        "{\"id\":0,\"method\":\"execute\",\"params\":{\"command\":\"create slideshow Bench\"}}\n"
+        "{\"id\":0,\"method\":\"add\",\"params\":[\"slide\"]}\n"
+        "{\"id\":0,\"method\":\"add\",\"params\":[\"rect\",10,10,100,50,\"Title\"]}\n";
+    if (!sendAll(fd, setup) || !readLines(fd, buf, 3)) { ::close(fd); return false; }
+
+    int sent = 0;
+    while (sent < requests) {
+        const int batch = std::min(depth, requests - sent);
+        std::string out;
+        for (int i = 0; i < batch; ++i, ++sent) {
+            out += "{\"id\":" + std::to_string(sent + 1);
+            out += (sent % 2 == 0)
+                       ? ",\"method\":\"move\",\"params\":[\"shape\",1," + std::to_string(sent % 500) + ",20]}\n"
+                       : ",\"method\":\"state\"}\n";
+        }
+        if (!sendAll(fd, out) || !readLines(fd, buf, batch)) { ::close(fd); return false; }
+    }
+    ::close(fd);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int requests = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    const int clients = (argc > 2) ? std::atoi(argv[2]) : 4;
+    const int depth = (argc > 3) ? std::atoi(argv[3]) : 32;
+
+    const std::string path = "/tmp/slideshow_bench_" + std::to_string(::getpid()) + ".sock";
+
+    RpcServer server(path);
+    if (!server.listen()) return 1;
+    std::thread serverThread([&]() { server.run(); });
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    std::vector<char> ok(static_cast<size_t>(clients), 0);
+    for (int i = 0; i < clients; ++i)
+        threads.emplace_back([&, i]() { ok[static_cast<size_t>(i)] = runClient(path, requests, depth); });
+    for (auto& t : threads) t.join();
+    const auto t1 = std::chrono::steady_clock::now();
+
+    server.stop();
+    serverThread.join();
+
+    for (char c : ok) {
+        if (!c) {
+            std::fprintf(stderr, "client failed\n");
+            return 1;
+        }
+    }
+
+    const double secs = std::chrono::duration<double>(t1 - t0).count();
+    const double total = double(requests) * clients;
+    std::fprintf(stderr, "clients=%d requests=%d depth=%d time=%.3fs throughput=%.0f req/s\n",
+                 clients, requests, depth, secs, total / secs);
+    return 0;
+}
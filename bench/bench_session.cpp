@@ -0,0 +1,204 @@
+// Cost of keeping the presentation order/index current with many open
+// presentations. Runs ordinary commands against one Session (each followed
+// by rebuildUiIndex(), as the CLI loop does) and compares that with the
+// full rebuild the loop used to do after every command.
+//
+// Then checks that sessions are independent: each of [threads] threads
+// drives its own Session through generate, edits and save, and the result
+// (in memory and reloaded from its file) must be exactly that thread's.
+// Exit status 1 if any thread's result is wrong.
+//
+//   bench_session [presentations] [commands] [threads]
+
+#include "CommandParser.hpp"
+#include "Commands.hpp"
+#include "ICommand.hpp"
+#include "Log.hpp"
+#include "PPTXSerializer.hpp"
+#include "Session.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// The previous rebuild: nested linear searches and an ordered map.
+void legacyRebuild(const std::vector<SlideShow>& slideshows, std::vector<std::string>& order,
+                   std::map<std::string, size_t>& index)
+{
+    index.clear();
+    std::vector<std::string> newOrder;
+    newOrder.reserve(order.size());
+    for (const auto& name : order) {
+        auto it = std::find_if(slideshows.begin(), slideshows.end(),
+                               [&](const SlideShow& s) { return s.getFilename() == name; });
+        if (it != slideshows.end()) newOrder.push_back(name);
+    }
+    for (const auto& ss : slideshows) {
+        if (std::find(newOrder.begin(), newOrder.end(), ss.getFilename()) == newOrder.end())
+            newOrder.push_back(ss.getFilename());
+    }
+    order = std::move(newOrder);
+    for (size_t i = 0; i < slideshows.size(); ++i) index[slideshows[i].getFilename()] = i;
+}
+
+constexpr int kDeckSlides = 30;
+
+// One thread's work: a deck of its own, a marked slide, a save. Returns
+// an empty string if everything it can see is what it made.
+std::string runSession(int n, const std::string& file)
+{
+    const std::string marker = "marker-" + std::to_string(n);
+    const std::string lines[] = {
+        "generate deck " + std::to_string(kDeckSlides) + " 10 seed=" + std::to_string(n + 1) +
+            " name=deck" + std::to_string(n),
+        "add slide",
+        "add rect 10 20 100 50 filler",
+        "add ellipse 5 5 40 40 " + marker,
+        "move shape 2 " + std::to_string(n) + " " + std::to_string(2 * n),
+        "remove shape 1",
+        "save " + file,
+    };
+
+    Session session;
+    const size_t errorsBefore = logging::errorCount();
+    for (const auto& line : lines) {
+        std::istringstream in(line);
+        auto cmd = CommandParser::parse(in, session);
+        if (!cmd) return "does not parse: " + line;
+        if (isUndoableCommand(cmd.get())) session.snapshot();
+        cmd->execute();
+        session.rebuildUiIndex();
+    }
+    if (logging::errorCount() != errorsBefore) return "a command reported an error";
+
+    // What this session holds.
+    const auto& shows = session.getSlideshows();
+    if (shows.size() != 1 || shows[0].getFilename() != "deck" + std::to_string(n))
+        return "wrong presentations";
+    const auto& slides = shows[0].getSlides();
+    if (slides.size() != kDeckSlides + 1) return "wrong slide count";
+    const auto& shapes = slides.back().getShapes();
+    if (shapes.size() != 1 || shapes[0].getText() != marker || shapes[0].getX() != n ||
+        shapes[0].getY() != 2 * n)
+        return "wrong last slide";
+
+    // Its text index sees its own marker and no other thread's.
+    const auto hits = session.findText("marker-");
+    if (hits.size() != 1 || hits[0].id != shapes[0].getId()) return "wrong search result";
+
+    // What it wrote.
+    std::vector<SlideShow> loaded;
+    PresentationIndex index;
+    std::vector<std::string> order;
+    size_t current = 0;
+    if (!PPTXSerializer::load(loaded, index, order, current, file)) return "cannot load " + file;
+    if (loaded.size() != 1 || loaded[0].getSlides().size() != kDeckSlides + 1) return "saved file differs";
+    const auto& saved = loaded[0].getSlides().back().getShapes();
+    if (saved.size() != 1 || saved[0].getText() != marker) return "saved last slide differs";
+    return {};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int presentations = argc > 1 ? std::atoi(argv[1]) : 5000;
+    const int commands = argc > 2 ? std::atoi(argv[2]) : 200;
+    const int threads = argc > 3 ? std::atoi(argv[3]) : 8;
+
+    Session session;
+    auto t0 = Clock::now();
+    for (int i = 0; i < presentations; ++i) {
+        SlideShow ss("deck_" + std::to_string(i) + ".pptx");
+        ss.getSlides().emplace_back();
+        session.addPresentation(std::move(ss));
+    }
+    const double addTime = secondsSince(t0);
+
+    const char* lines[] = {"add rect 10 10 100 50 \"Title\"", "nextfile", "next", "prevfile"};
+
+    // Commands print their results; keep the measurement about the model.
+    std::ostringstream sink;
+    std::streambuf* old = std::cout.rdbuf(sink.rdbuf());
+
+    t0 = Clock::now();
+    for (int i = 0; i < commands; ++i) {
+        std::istringstream in(lines[i % 4]);
+        auto cmd = CommandParser::parse(in, session);
+        if (cmd) cmd->execute();
+        session.rebuildUiIndex();
+    }
+    const double cmdTime = secondsSince(t0);
+
+    std::cout.rdbuf(old);
+
+    t0 = Clock::now();
+    for (int i = 0; i < commands; ++i) {
+        session.markPresentationsDirty();
+        session.rebuildUiIndex();
+    }
+    const double fullTime = secondsSince(t0);
+
+    std::vector<std::string> order = session.getPresentationOrder();
+    std::map<std::string, size_t> index;
+    const int legacyRuns = std::max(1, commands / 20);
+    t0 = Clock::now();
+    for (int i = 0; i < legacyRuns; ++i) legacyRebuild(session.getSlideshows(), order, index);
+    const double legacyTime = secondsSince(t0);
+
+    std::fprintf(stderr, "presentations=%d add_all=%.3fms\n", presentations, addTime * 1e3);
+    std::fprintf(stderr, "command+index:   %10.2f us/command (%d commands)\n",
+                 cmdTime * 1e6 / commands, commands);
+    std::fprintf(stderr, "full rebuild:    %10.2f us\n", fullTime * 1e6 / commands);
+    std::fprintf(stderr, "legacy rebuild:  %10.2f us (previously paid after every command)\n",
+                 legacyTime * 1e6 / legacyRuns);
+
+    // Parallel sessions. Only errors are printed; each thread counts its own.
+    const logging::Level level = logging::minLevel();
+    logging::setMinLevel(logging::Level::Error);
+    old = std::cout.rdbuf(sink.rdbuf());
+
+    std::vector<std::string> results(static_cast<size_t>(threads));
+    std::vector<std::string> files;
+    for (int i = 0; i < threads; ++i)
+        files.push_back("/tmp/bench_session_" + std::to_string(::getpid()) + "_" + std::to_string(i) + ".pptx");
+
+    t0 = Clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back([&, i] { results[size_t(i)] = runSession(i, files[size_t(i)]); });
+    for (auto& t : workers) t.join();
+    const double parallelTime = secondsSince(t0);
+
+    std::cout.rdbuf(old);
+    logging::setMinLevel(level);
+    for (const auto& f : files) std::remove(f.c_str());
+
+    int failed = 0;
+    for (int i = 0; i < threads; ++i) {
+        if (results[size_t(i)].empty()) continue;
+        std::fprintf(stderr, "session %d: %s\n", i, results[size_t(i)].c_str());
+        ++failed;
+    }
+    std::fprintf(stderr, "parallel sessions: %d threads, %.2f ms, %s\n", threads, parallelTime * 1e3,
+                 failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -1,7 +1,9 @@
 #include "gui/CanvasView.hpp"
+#include "gui/SlideRenderer.hpp"
 
 #include "Slide.hpp"
 #include "Shape.hpp"
+#include "Profiler.hpp"
 
 #include <QGraphicsScene>
 #include <QGraphicsTextItem>
@@ -16,119 +18,73 @@
 #include <QPixmap>
 #include <QFont>
 #include <QPalette>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QElapsedTimer>
+#include <QPaintEvent>
+#include <QThread>
+#include <QMetaObject>
 #include <cmath>
 #include <algorithm>
+#include <unordered_map>
 
 namespace {
-constexpr int kSlideW = 960;
-constexpr int kSlideH = 540;
-constexpr int kGridStep = 25;
-
-// A movable/selectable graphics item that reports its final position to CanvasView
-// on mouse release. We keep the "shape index" in data(0) so selection works.
-class TaggedRectItem : public QGraphicsRectItem {
-public:
-    TaggedRectItem(int idx, const QRectF& r, CanvasView* view)
-        : QGraphicsRectItem(r), idx_(idx), view_(view) {
-        setData(0, idx_);
-        setFlag(QGraphicsItem::ItemIsSelectable, true);
-        setFlag(QGraphicsItem::ItemIsMovable, true);
-    }
-
-protected:
-    void mousePressEvent(QGraphicsSceneMouseEvent* e) override {
-        startPos_ = pos();
-        QGraphicsRectItem::mousePressEvent(e);
-    }
-
-    void mouseReleaseEvent(QGraphicsSceneMouseEvent* e) override {
-        QGraphicsRectItem::mouseReleaseEvent(e);
-        if (view_ && pos() != startPos_) view_->notifyShapeMoved(idx_, pos());
-    }
-
-private:
-    int idx_ = -1;
-    CanvasView* view_ = nullptr;
-    QPointF startPos_;
-};
-
-class TaggedEllipseItem : public QGraphicsEllipseItem {
+using render::kSlideW;
+using render::kSlideH;
+// Grid cells per side of the cached grid tile.
+constexpr int kGridTileCells = 8;
+// Placeholder size for images whose shape has no size of its own.
+constexpr int kPlaceholderW = 200;
+constexpr int kPlaceholderH = 150;
+
+// A movable/selectable shape item. The shape index lives in data(0) (updated
+// when shapes are reordered). Presses and releases are reported to CanvasView,
+// which commits the moves of every selected item once the drag ends.
+template <class Base>
+class Tagged : public Base {
 public:
-    TaggedEllipseItem(int idx, const QRectF& r, CanvasView* view)
-        : QGraphicsEllipseItem(r), idx_(idx), view_(view) {
-        setData(0, idx_);
-        setFlag(QGraphicsItem::ItemIsSelectable, true);
-        setFlag(QGraphicsItem::ItemIsMovable, true);
+    template <class Arg>
+    Tagged(int idx, const Arg& arg, CanvasView* view)
+        : Base(arg), view_(view) {
+        this->setData(0, idx);
+        this->setFlag(QGraphicsItem::ItemIsSelectable, true);
+        this->setFlag(QGraphicsItem::ItemIsMovable, true);
     }
 
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent* e) override {
-        startPos_ = pos();
-        QGraphicsEllipseItem::mousePressEvent(e);
+        // The base class updates the selection first; the drag moves all of it.
+        Base::mousePressEvent(e);
+        if (view_) view_->beginDrag();
     }
 
     void mouseReleaseEvent(QGraphicsSceneMouseEvent* e) override {
-        QGraphicsEllipseItem::mouseReleaseEvent(e);
-        if (view_ && pos() != startPos_) view_->notifyShapeMoved(idx_, pos());
+        Base::mouseReleaseEvent(e);
+        if (view_) view_->endDrag();
     }
 
 private:
-    int idx_ = -1;
     CanvasView* view_ = nullptr;
-    QPointF startPos_;
 };
 
-class TaggedPixmapItem : public QGraphicsPixmapItem {
-public:
-    TaggedPixmapItem(int idx, const QPixmap& pm, CanvasView* view)
-        : QGraphicsPixmapItem(pm), idx_(idx), view_(view) {
-        setData(0, idx_);
-        setFlag(QGraphicsItem::ItemIsSelectable, true);
-        setFlag(QGraphicsItem::ItemIsMovable, true);
-    }
+using TaggedRectItem = Tagged<QGraphicsRectItem>;
+using TaggedEllipseItem = Tagged<QGraphicsEllipseItem>;
+using TaggedPixmapItem = Tagged<QGraphicsPixmapItem>;
+using TaggedTextItem = Tagged<QGraphicsTextItem>;
 
-protected:
-    void mousePressEvent(QGraphicsSceneMouseEvent* e) override {
-        startPos_ = pos();
-        QGraphicsPixmapItem::mousePressEvent(e);
-    }
-
-    void mouseReleaseEvent(QGraphicsSceneMouseEvent* e) override {
-        QGraphicsPixmapItem::mouseReleaseEvent(e);
-        if (view_ && pos() != startPos_) view_->notifyShapeMoved(idx_, pos());
-    }
-
-private:
-    int idx_ = -1;
-    CanvasView* view_ = nullptr;
-    QPointF startPos_;
-};
-
-class TaggedTextItem : public QGraphicsTextItem {
-public:
-    TaggedTextItem(int idx, const QString& text, CanvasView* view)
-        : QGraphicsTextItem(text), idx_(idx), view_(view) {
-        setData(0, idx_);
-        setFlag(QGraphicsItem::ItemIsSelectable, true);
-        setFlag(QGraphicsItem::ItemIsMovable, true);
-    }
-
-protected:
-    void mousePressEvent(QGraphicsSceneMouseEvent* e) override {
-        startPos_ = pos();
-        QGraphicsTextItem::mousePressEvent(e);
-    }
-
-    void mouseReleaseEvent(QGraphicsSceneMouseEvent* e) override {
-        QGraphicsTextItem::mouseReleaseEvent(e);
-        if (view_ && pos() != startPos_) view_->notifyShapeMoved(idx_, pos());
-    }
-
-private:
-    int idx_ = -1;
-    CanvasView* view_ = nullptr;
-    QPointF startPos_;
-};
+// Shown in place of an image until its decode finishes (or fails).
+QPixmap placeholderPixmap(const QSize& size, const QString& label)
+{
+    QPixmap pm(size);
+    pm.fill(QColor(235, 235, 235));
+
+    QPainter p(&pm);
+    p.setPen(QPen(QColor(160, 160, 160), 1, Qt::DashLine));
+    p.drawRect(0, 0, size.width() - 1, size.height() - 1);
+    p.setPen(QColor(110, 110, 110));
+    p.drawText(pm.rect(), Qt::AlignCenter, label);
+    return pm;
+}
 }
 
 CanvasView::CanvasView(QWidget* parent)
@@ -140,14 +96,26 @@ CanvasView::CanvasView(QWidget* parent)
     setRenderHint(QPainter::TextAntialiasing, true);
     setRenderHint(QPainter::SmoothPixmapTransform, true);
 
-    setDragMode(QGraphicsView::ScrollHandDrag);
+    // Drag on empty canvas selects; hold Space to pan.
+    setDragMode(QGraphicsView::RubberBandDrag);
     setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
     setResizeAnchor(QGraphicsView::AnchorViewCenter);
 
+    // Repaint only what changed: items invalidate their own bounding boxes
+    // (selection, moves, swapped pixmaps) and Qt merges them into few rects.
+    // The background (page colour, grid) is cached per viewport.
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+    setCacheMode(QGraphicsView::CacheBackground);
+
     setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
     setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
 
+    // Leave a core for the GUI thread.
+    decodePool_.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+
     connect(scene_, &QGraphicsScene::selectionChanged, this, [this]() {
+        // renderSlide() reports the net change once it is done.
+        if (updating_) return;
         const auto items = scene_->selectedItems();
         if (items.isEmpty()) {
             emit selectionCleared();
@@ -165,6 +133,13 @@ CanvasView::CanvasView(QWidget* parent)
     showMessage("No presentation.\nUse File -> New Presentation");
 }
 
+CanvasView::~CanvasView()
+{
+    // Workers post results to this object; none may be running past here.
+    dropPendingDecodes();
+    decodePool_.waitForDone();
+}
+
 void CanvasView::ensureScene()
 {
     if (!scene_) {
@@ -177,6 +152,50 @@ void CanvasView::clearScene()
 {
     ensureScene();
     scene_->clear();
+    dragStart_.clear();
+    dropPendingDecodes();
+    items_.clear();
+    strays_.clear();
+    page_ = nullptr;
+    emptyHint_ = nullptr;
+}
+
+CanvasView::ShapeItem CanvasView::describe(const ::Shape& sh)
+{
+    ShapeItem d;
+    d.kind = static_cast<int>(sh.kind());
+    d.w = sh.getW();
+    d.h = sh.getH();
+    d.text = sh.getText();
+    if (sh.isImage()) {
+        d.imageHash = sh.getImageHash();
+        d.imageBytes = sh.getImageData().size();
+        d.cropL = sh.getCropL();
+        d.cropT = sh.getCropT();
+        d.cropR = sh.getCropR();
+        d.cropB = sh.getCropB();
+    }
+    return d;
+}
+
+bool CanvasView::ShapeItem::sameLook(const ShapeItem& o) const
+{
+    return kind == o.kind && w == o.w && h == o.h && text == o.text &&
+           imageHash == o.imageHash && imageBytes == o.imageBytes &&
+           cropL == o.cropL && cropT == o.cropT && cropR == o.cropR && cropB == o.cropB;
+}
+
+PixmapCache::Key CanvasView::ShapeItem::imageKey() const
+{
+    return {imageHash, imageBytes, cropL, cropT, cropR, cropB, w, h};
+}
+
+int CanvasView::selectedIndex() const
+{
+    const auto items = scene_->selectedItems();
+    if (items.isEmpty()) return -1;
+    const QVariant v = items.first()->data(0);
+    return v.isValid() ? v.toInt() : -1;
 }
 
 void CanvasView::showMessage(const QString& msg)
@@ -196,166 +215,338 @@ void CanvasView::showMessage(const QString& msg)
     t->setPos((kSlideW - r.width()) * 0.5, (kSlideH - r.height()) * 0.5);
 }
 
+QGraphicsItem* CanvasView::createShapeItem(const ::Shape& sh, int i)
+{
+    // -------------------------
+    // Images
+    // -------------------------
+    if (sh.isImage()) {
+        const PixmapCache::Key key = render::imageKey(sh);
+        QPixmap pm = pixmaps_.find(key);
+        if (pm.isNull()) {
+            requestDecode(sh, key);
+            pm = placeholderPixmap(render::fitToSlide(sh.getW() > 1 ? sh.getW() : kPlaceholderW,
+                                              sh.getH() > 1 ? sh.getH() : kPlaceholderH),
+                                   "Loading image...");
+        }
+
+        auto* item = new TaggedPixmapItem(i, pm, this);
+        item->setPos(sh.getX(), sh.getY());
+        scene_->addItem(item);
+        return item;
+    }
+
+    // -------------------------
+    // Rectangles / Ellipses
+    // -------------------------
+    if (sh.kind() == ShapeKind::Rect || sh.kind() == ShapeKind::Ellipse) {
+        QPen pen(Qt::black);
+        QBrush brush(QColor(230, 230, 230));
+
+        const QRectF localRect(0, 0,
+                               std::max(1, sh.getW()),
+                               std::max(1, sh.getH()));
+
+        QGraphicsItem* base = nullptr;
+        if (sh.kind() == ShapeKind::Rect) {
+            auto* r = new TaggedRectItem(i, localRect, this);
+            r->setPen(pen);
+            r->setBrush(brush);
+            r->setPos(sh.getX(), sh.getY());
+            scene_->addItem(r);
+            base = r;
+        } else {
+            auto* e = new TaggedEllipseItem(i, localRect, this);
+            e->setPen(pen);
+            e->setBrush(brush);
+            e->setPos(sh.getX(), sh.getY());
+            scene_->addItem(e);
+            base = e;
+        }
+
+        // Put the label INSIDE the shape (local coordinates).
+        QString text = QString::fromStdString(sh.getText());
+        if (!text.isEmpty()) {
+            auto* t = new QGraphicsTextItem(text, base);
+            QFont f = t->font();
+            f.setPointSize(14);
+            t->setFont(f);
+            t->setDefaultTextColor(Qt::black);
+            t->setPos(10, 8);
+            t->setFlag(QGraphicsItem::ItemIsSelectable, false);
+            t->setFlag(QGraphicsItem::ItemIsMovable, false);
+            t->setAcceptedMouseButtons(Qt::NoButton);
+            // Text layout is the costly part of painting; reuse it.
+            t->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+        }
+
+        return base;
+    }
+
+    // -------------------------
+    // Text
+    // -------------------------
+    QString text = QString::fromStdString(sh.getText());
+    auto* item = new TaggedTextItem(i, text, this);
+
+    QFont f = item->font();
+    f.setPointSize(16);
+    item->setFont(f);
+    item->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+
+    item->setPos(sh.getX(), sh.getY());
+    scene_->addItem(item);
+    return item;
+}
+
+// Items are matched to shapes by Shape::getId(). A shape that only moved or
+// changed position in the list keeps its item (and its selection); one whose
+// look changed gets a new item; items of removed shapes are deleted.
 void CanvasView::renderSlide(const ::Slide& slide)
 {
-    clearScene();
-    scene_->setSceneRect(0, 0, kSlideW, kSlideH);
+    PROFILE_SCOPE(prof::Phase::GuiRender);
+    QElapsedTimer timer;
+    timer.start();
+    ensureScene();
 
-    auto* page = scene_->addRect(0, 0, kSlideW, kSlideH, QPen(Qt::black), QBrush(Qt::white));
-    page->setZValue(-10);
+    updating_ = true;
+    dragStart_.clear();
+    const int selectedBefore = selectedIndex();
+
+    if (!page_) {
+        clearScene();
+        scene_->setSceneRect(0, 0, kSlideW, kSlideH);
+        page_ = scene_->addRect(0, 0, kSlideW, kSlideH, QPen(Qt::black), QBrush(Qt::white));
+        page_->setZValue(-10);
+    }
 
     const auto& shapes = slide.getShapes();
-    if (shapes.empty()) {
-        auto* t = scene_->addText("Empty slide");
-        t->setPos(30, 30);
-        return;
+    if (shapes.empty() && !emptyHint_) {
+        emptyHint_ = scene_->addText("Empty slide");
+        emptyHint_->setPos(30, 30);
+    } else if (!shapes.empty() && emptyHint_) {
+        delete emptyHint_;
+        emptyHint_ = nullptr;
     }
 
-    for (int i = 0; i < (int)shapes.size(); ++i) {
-        const ::Shape& sh = shapes[(size_t)i];
+    for (QGraphicsItem* it : strays_) delete it;
+    strays_.clear();
 
-        // -------------------------
-        // Images
-        // -------------------------
-        if (sh.isImage()) {
-            const auto& data = sh.getImageData();
-            QByteArray bytes(reinterpret_cast<const char*>(data.data()),
-                             static_cast<int>(data.size()));
-
-            QImage img = QImage::fromData(bytes);
-            if (img.isNull()) {
-                auto* err = new TaggedTextItem(i, "[Image decode failed]", this);
-                err->setPos(sh.getX(), sh.getY());
-                scene_->addItem(err);
-                continue;
-            }
+    // No shape carried over: the user moved to another slide, so decodes
+    // still queued for the previous one are no longer wanted.
+    if (!items_.empty() &&
+        std::none_of(shapes.begin(), shapes.end(),
+                     [this](const ::Shape& sh) { return items_.count(sh.getId()) != 0; })) {
+        dropPendingDecodes();
+    }
 
-            
-            // Apply PPTX-style crop (a:srcRect). Values are 0..100000 (1/1000 of a percent).
-            const int cl = sh.getCropL();
-            const int ct = sh.getCropT();
-            const int cr = sh.getCropR();
-            const int cb = sh.getCropB();
-            if ((cl | ct | cr | cb) != 0) {
-                const int W = img.width();
-                const int H = img.height();
-
-                int x0 = (int)std::round((double)cl * (double)W / 100000.0);
-                int y0 = (int)std::round((double)ct * (double)H / 100000.0);
-                int x1 = W - (int)std::round((double)cr * (double)W / 100000.0);
-                int y1 = H - (int)std::round((double)cb * (double)H / 100000.0);
-
-                x0 = std::clamp(x0, 0, W);
-                y0 = std::clamp(y0, 0, H);
-                x1 = std::clamp(x1, 0, W);
-                y1 = std::clamp(y1, 0, H);
-
-                int cw = std::max(1, x1 - x0);
-                int ch = std::max(1, y1 - y0);
-                img = img.copy(x0, y0, cw, ch);
-            }
+    std::unordered_map<uint64_t, ShapeItem> next;
+    next.reserve(shapes.size());
 
-int targetW = (sh.getW() > 1) ? sh.getW() : img.width();
-            int targetH = (sh.getH() > 1) ? sh.getH() : img.height();
-            if (targetW <= 0) targetW = 1;
-            if (targetH <= 0) targetH = 1;
-
-            // Keep images reasonable inside the slide view.
-            const int maxW = kSlideW;
-            const int maxH = kSlideH;
-            if (targetW > maxW || targetH > maxH) {
-                double sx = (double)maxW / (double)targetW;
-                double sy = (double)maxH / (double)targetH;
-                double s = std::min(sx, sy);
-                targetW = std::max(1, (int)std::round(targetW * s));
-                targetH = std::max(1, (int)std::round(targetH * s));
+    for (int i = 0; i < (int)shapes.size(); ++i) {
+        const ::Shape& sh = shapes[(size_t)i];
+        const ShapeItem look = describe(sh);
+
+        ShapeItem entry;
+        auto old = items_.find(sh.getId());
+        if (old != items_.end() && old->second.sameLook(look)) {
+            entry = std::move(old->second);
+            items_.erase(old);
+            if (entry.x != sh.getX() || entry.y != sh.getY()) entry.item->setPos(sh.getX(), sh.getY());
+            if (entry.index != i) entry.item->setData(0, i);
+        } else {
+            bool wasSelected = false;
+            if (old != items_.end()) {
+                wasSelected = old->second.item->isSelected();
+                delete old->second.item;
+                items_.erase(old);
             }
+            entry = look;
+            entry.item = createShapeItem(sh, i);
+            entry.loading = sh.isImage() && decoding_.count(entry.imageKey()) != 0;
+            if (wasSelected) entry.item->setSelected(true);
+        }
+        entry.index = i;
+        entry.x = sh.getX();
+        entry.y = sh.getY();
+        entry.item->setZValue(i);
+
+        auto [slot, inserted] = next.try_emplace(sh.getId(), std::move(entry));
+        if (!inserted) {
+            // Ids are unique per document; a clash would otherwise lose an item.
+            strays_.push_back(slot->second.item);
+            slot->second = std::move(entry);
+        }
+    }
 
-            QPixmap pm = QPixmap::fromImage(img);
-            if (pm.width() != targetW || pm.height() != targetH) {
-                pm = pm.scaled(targetW, targetH, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-            }
+    for (auto& [id, entry] : items_) delete entry.item;
+    items_ = std::move(next);
 
-            auto* item = new TaggedPixmapItem(i, pm, this);
-            item->setPos(sh.getX(), sh.getY());
-            scene_->addItem(item);
-            continue;
-        }
+    updating_ = false;
+    lastRenderNs_ = timer.nsecsElapsed();
+    const int selectedAfter = selectedIndex();
+    if (selectedAfter != selectedBefore) {
+        if (selectedAfter < 0) emit selectionCleared();
+        else emit shapeSelected(selectedAfter);
+    }
+}
 
-        // -------------------------
-        // Rectangles / Ellipses
-        // -------------------------
-        if (sh.kind() == ShapeKind::Rect || sh.kind() == ShapeKind::Ellipse) {
-            QPen pen(Qt::black);
-            QBrush brush(QColor(230, 230, 230));
-
-            const QRectF localRect(0, 0,
-                                   std::max(1, sh.getW()),
-                                   std::max(1, sh.getH()));
-
-            QGraphicsItem* base = nullptr;
-            if (sh.kind() == ShapeKind::Rect) {
-                auto* r = new TaggedRectItem(i, localRect, this);
-                r->setPen(pen);
-                r->setBrush(brush);
-                r->setPos(sh.getX(), sh.getY());
-                scene_->addItem(r);
-                base = r;
-            } else {
-                auto* e = new TaggedEllipseItem(i, localRect, this);
-                e->setPen(pen);
-                e->setBrush(brush);
-                e->setPos(sh.getX(), sh.getY());
-                scene_->addItem(e);
-                base = e;
-            }
+void CanvasView::requestDecode(const ::Shape& sh, const PixmapCache::Key& key)
+{
+    if (!decoding_.insert(key).second) return;  // already on its way
+
+    // Deep copy: the shape may change or go away while the worker runs.
+    const auto& data = sh.getImageData();
+    QByteArray bytes(reinterpret_cast<const char*>(data.data()), static_cast<qsizetype>(data.size()));
+    const uint64_t generation = decodeGen_.load();
+
+    decodePool_.start([this, generation, key, bytes]() {
+        if (decodeGen_.load() != generation) return;
+        QImage img = render::decodeImage(bytes, key);
+        QMetaObject::invokeMethod(this, [this, generation, key, img = std::move(img)]() {
+            imageDecoded(generation, key, img);
+        }, Qt::QueuedConnection);
+    });
+}
 
-            // Put the label INSIDE the shape (local coordinates).
-            QString text = QString::fromStdString(sh.getText());
-            if (!text.isEmpty()) {
-                auto* t = new QGraphicsTextItem(text, base);
-                QFont f = t->font();
-                f.setPointSize(14);
-                t->setFont(f);
-                t->setDefaultTextColor(Qt::black);
-                t->setPos(10, 8);
-                t->setFlag(QGraphicsItem::ItemIsSelectable, false);
-                t->setFlag(QGraphicsItem::ItemIsMovable, false);
-                t->setAcceptedMouseButtons(Qt::NoButton);
-            }
+void CanvasView::imageDecoded(uint64_t generation, const PixmapCache::Key& key, const QImage& img)
+{
+    if (generation != decodeGen_.load()) return;
+    decoding_.erase(key);
+
+    QPixmap pm;
+    if (!img.isNull()) {
+        pm = QPixmap::fromImage(img);
+        pixmaps_.insert(key, pm);
+    }
 
-            continue;
+    for (auto& [id, entry] : items_) {
+        if (!entry.loading || !(entry.imageKey() == key)) continue;
+        auto* item = static_cast<QGraphicsPixmapItem*>(entry.item);
+        if (pm.isNull()) {
+            item->setPixmap(placeholderPixmap(item->pixmap().size(), "[Image decode failed]"));
+        } else {
+            item->setPixmap(pm);
         }
+        entry.loading = false;
+    }
+}
 
-        // -------------------------
-        // Text
-        // -------------------------
-        QString text = QString::fromStdString(sh.getText());
-        auto* item = new TaggedTextItem(i, text, this);
+void CanvasView::dropPendingDecodes()
+{
+    ++decodeGen_;
+    decodePool_.clear();
+    decoding_.clear();
+}
+
+void CanvasView::beginDrag()
+{
+    dragStart_.clear();
+    for (QGraphicsItem* it : scene_->selectedItems()) {
+        if (it->data(0).isValid()) dragStart_.emplace_back(it, it->pos());
+    }
+}
 
-        QFont f = item->font();
-        f.setPointSize(16);
-        item->setFont(f);
+void CanvasView::endDrag()
+{
+    QVector<ShapeMove> moves;
+    for (const auto& [item, start] : dragStart_) {
+        item->setPos(grid_.apply(item->pos()));
+        if (item->pos() == start) continue;
+        // Convert to integer canvas pixels.
+        moves.push_back({item->data(0).toInt(),
+                         static_cast<int>(std::round(item->pos().x())),
+                         static_cast<int>(std::round(item->pos().y()))});
+    }
+    dragStart_.clear();
+    if (!moves.isEmpty()) emit shapesMoved(moves);
+}
 
-        item->setPos(sh.getX(), sh.getY());
-        scene_->addItem(item);
+void CanvasView::keyPressEvent(QKeyEvent* e)
+{
+    if (e->key() == Qt::Key_Space && !e->isAutoRepeat()) {
+        setDragMode(QGraphicsView::ScrollHandDrag);
+        return;
     }
+    QGraphicsView::keyPressEvent(e);
 }
 
-void CanvasView::notifyShapeMoved(int index, const QPointF& newPos)
+void CanvasView::keyReleaseEvent(QKeyEvent* e)
 {
-    // Convert to integer canvas pixels.
-    const int x = static_cast<int>(std::round(newPos.x()));
-    const int y = static_cast<int>(std::round(newPos.y()));
-    emit shapeMoved(index, x, y);
+    if (e->key() == Qt::Key_Space && !e->isAutoRepeat()) {
+        setDragMode(QGraphicsView::RubberBandDrag);
+        return;
+    }
+    QGraphicsView::keyReleaseEvent(e);
 }
 
 void CanvasView::setShowGrid(bool on)
 {
-    showGrid_ = on;
+    grid_.visible = on;
+    resetCachedContent();
     viewport()->update();
 }
 
+void CanvasView::setFrameOverlay(bool on)
+{
+    if (on && !frameOverlay_) {
+        // A separate opaque widget: updating its text does not repaint the scene.
+        frameOverlay_ = new QLabel(this);
+        frameOverlay_->setAutoFillBackground(true);
+        frameOverlay_->setMargin(4);
+        frameOverlay_->setAttribute(Qt::WA_TransparentForMouseEvents);
+        frameOverlay_->move(viewport()->pos() + QPoint(6, 6));
+        frameOverlay_->setText("paint: -");
+        frameOverlay_->adjustSize();
+    }
+    if (frameOverlay_) frameOverlay_->setVisible(on);
+}
+
+void CanvasView::paintEvent(QPaintEvent* e)
+{
+    QElapsedTimer timer;
+    timer.start();
+    {
+        PROFILE_SCOPE(prof::Phase::GuiPaint);
+        QGraphicsView::paintEvent(e);
+    }
+    const qint64 ns = timer.nsecsElapsed();
+    emit framePainted(ns);
+    if (!frameOverlay_ || !frameOverlay_->isVisible()) return;
+
+    const double ms = ns / 1e6;
+    avgFrameMs_ = avgFrameMs_ == 0 ? ms : avgFrameMs_ * 0.9 + ms * 0.1;
+
+    qint64 area = 0;
+    for (const QRect& r : e->region()) area += qint64(r.width()) * r.height();
+    const qint64 full = qint64(viewport()->width()) * viewport()->height();
+    const int pct = full > 0 ? int(std::min<qint64>(100, area * 100 / full)) : 0;
+
+    frameOverlay_->setText(QString("paint %1 ms (avg %2) | %3% repainted | %4 items")
+                               .arg(ms, 0, 'f', 2).arg(avgFrameMs_, 0, 'f', 2)
+                               .arg(pct).arg(items_.size()));
+    frameOverlay_->adjustSize();
+}
+
+qint64 CanvasView::takeRenderNs()
+{
+    const qint64 ns = lastRenderNs_;
+    lastRenderNs_ = -1;
+    return ns;
+}
+
+void CanvasView::changeEvent(QEvent* e)
+{
+    // The grid colour comes from the palette.
+    if (e->type() == QEvent::PaletteChange) resetCachedContent();
+    QGraphicsView::changeEvent(e);
+}
+
+void CanvasView::setSnapToGrid(bool on)
+{
+    grid_.snap = on;
+}
+
 void CanvasView::zoomIn()
 {
     constexpr double factor = 1.15;
@@ -380,30 +571,50 @@ void CanvasView::drawBackground(QPainter* painter, const QRectF& rect)
 {
     QGraphicsView::drawBackground(painter, rect);
 
-    if (!showGrid_) return;
-
-    painter->save();
+    if (!grid_.visible) return;
 
     QColor gridColor = palette().color(QPalette::Midlight);
     gridColor.setAlpha(120);
 
-    QPen pen(gridColor);
-    pen.setWidth(0);
-    painter->setPen(pen);
-
-    const int left   = static_cast<int>(std::floor(rect.left()));
-    const int right  = static_cast<int>(std::ceil(rect.right()));
-    const int top    = static_cast<int>(std::floor(rect.top()));
-    const int bottom = static_cast<int>(std::ceil(rect.bottom()));
-
-    int firstX = left - (left % kGridStep);
-    int firstY = top  - (top  % kGridStep);
-
-    for (int x = firstX; x < right; x += kGridStep)
-        painter->drawLine(x, top, x, bottom);
+    // The tile is drawn at device resolution; rebuild it when the zoom,
+    // screen scale or palette changes.
+    const qreal scale = transform().m11() * devicePixelRatioF();
+    if (gridTile_.isNull() || gridTileScale_ != scale || gridTileColor_ != gridColor) {
+        gridTileScale_ = scale;
+        gridTileColor_ = gridColor;
+        gridTile_ = renderGridTile(scale, gridColor);
+    }
 
-    for (int y = firstY; y < bottom; y += kGridStep)
-        painter->drawLine(left, y, right, y);
+    // Start the tiling on a grid line.
+    const double span = double(grid_.step) * kGridTileCells;
+    auto phase = [span](double v) {
+        const double m = std::fmod(v, span);
+        return m < 0 ? m + span : m;
+    };
+    painter->drawTiledPixmap(rect, gridTile_, QPointF(phase(rect.left()), phase(rect.top())));
+}
 
-    painter->restore();
+// kGridTileCells x kGridTileCells grid cells with the lines on the top and
+// left edge of each cell, one device pixel wide.
+QPixmap CanvasView::renderGridTile(qreal scale, const QColor& color) const
+{
+    const double span = double(grid_.step) * kGridTileCells;
+    const int px = std::max(1, (int)std::ceil(span * scale));
+
+    QPixmap tile(px, px);
+    tile.fill(Qt::transparent);
+    {
+        QPainter p(&tile);
+        QPen pen(color);
+        pen.setWidth(0);
+        p.setPen(pen);
+        for (int i = 0; i < kGridTileCells; ++i) {
+            const int at = (int)std::round(i * px / double(kGridTileCells));
+            p.drawLine(at, 0, at, px - 1);
+            p.drawLine(0, at, px - 1, at);
+        }
+    }
+    // One tile covers exactly `span` scene units.
+    tile.setDevicePixelRatio(px / span);
+    return tile;
 }
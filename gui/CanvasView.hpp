@@ -1,24 +1,66 @@
 #pragma once
 
+#include "gui/GridModel.hpp"
+#include "gui/PixmapCache.hpp"
+
+#include <QColor>
 #include <QGraphicsView>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 class QGraphicsScene;
+class QGraphicsRectItem;
+class QGraphicsTextItem;
+class QImage;
+class QLabel;
 class Slide;
+class Shape;
+
+struct ShapeMove
+{
+    int index = -1;
+    int x = 0;
+    int y = 0;
+};
 
 class CanvasView : public QGraphicsView
 {
     Q_OBJECT
 public:
     explicit CanvasView(QWidget* parent = nullptr);
+    ~CanvasView() override;
 
     void showMessage(const QString& msg);
+    // Images not in imageCache() are decoded on a worker pool; their items
+    // show a sized placeholder until the pixmap arrives.
     void renderSlide(const ::Slide& slide);
 
     void setShowGrid(bool on);
+    // Paint time and repainted share of the viewport, top-left corner.
+    void setFrameOverlay(bool on);
+
+    // Duration of the last renderSlide() since the previous call, or -1.
+    qint64 takeRenderNs();
+    // Dropped shapes land on the nearest grid point.
+    void setSnapToGrid(bool on);
+
+    // Decoded images reused across renders; budget set from settings.
+    PixmapCache& imageCache() { return pixmaps_; }
+
+    // Called by shape items when a mouse drag on them starts and ends.
+    // endDrag() snaps the dragged items and emits shapesMoved() once.
+    void beginDrag();
+    void endDrag();
 
-    // Called by internal graphics items when the user drags a shape.
-    // Emits shapeMoved() with integer pixel coordinates in canvas space.
-    void notifyShapeMoved(int index, const QPointF& newPos);
+    const GridModel& grid() const { return grid_; }
 
 public slots:
     void zoomIn();
@@ -29,18 +71,76 @@ signals:
     void shapeSelected(int index);
     void selectionCleared();
 
-    // Fired once after a drag finishes (mouse release) if the shape moved.
-    void shapeMoved(int index, int x, int y);
+    // Fired once per drag (mouse release) with every shape that moved, in
+    // integer pixel coordinates in canvas space.
+    void shapesMoved(const QVector<ShapeMove>& moves);
+
+    // After every viewport paint, with its duration.
+    void framePainted(qint64 ns);
 
 protected:
     void drawBackground(QPainter* painter, const QRectF& rect) override;
+    void paintEvent(QPaintEvent* e) override;
+    void changeEvent(QEvent* e) override;
+    void keyPressEvent(QKeyEvent* e) override;
+    void keyReleaseEvent(QKeyEvent* e) override;
 
 private:
+    // The scene item of one shape and what it was built from.
+    struct ShapeItem
+    {
+        QGraphicsItem* item = nullptr;
+        int index = -1;
+        int x = 0, y = 0;
+
+        int kind = 0;
+        int w = 0, h = 0;
+        std::string text;
+        uint64_t imageHash = 0;
+        size_t imageBytes = 0;
+        int cropL = 0, cropT = 0, cropR = 0, cropB = 0;
+        bool loading = false;  // image item still showing its placeholder
+
+        PixmapCache::Key imageKey() const;
+        // Same appearance apart from position and list index.
+        bool sameLook(const ShapeItem& o) const;
+    };
+
     void ensureScene();
     void clearScene();
+    static ShapeItem describe(const ::Shape& sh);
+    QGraphicsItem* createShapeItem(const ::Shape& sh, int index);
+    int selectedIndex() const;
+    QPixmap renderGridTile(qreal scale, const QColor& color) const;
+
+    void requestDecode(const ::Shape& sh, const PixmapCache::Key& key);
+    void imageDecoded(uint64_t generation, const PixmapCache::Key& key, const QImage& img);
+    // Forgets queued and in-flight decodes; their results are dropped.
+    void dropPendingDecodes();
 
 private:
     QGraphicsScene* scene_ = nullptr;
-    bool showGrid_ = false;
+    GridModel grid_;
+    // Grid lines pre-rendered for the current zoom, blitted as tiles.
+    QPixmap gridTile_;
+    qreal gridTileScale_ = 0;
+    QColor gridTileColor_;
+
+    QLabel* frameOverlay_ = nullptr;
+    double avgFrameMs_ = 0;
+    qint64 lastRenderNs_ = -1;
     double zoom_ = 1.0;
+    PixmapCache pixmaps_;
+
+    // Current slide's items by Shape::getId().
+    std::unordered_map<uint64_t, ShapeItem> items_;
+    std::vector<QGraphicsItem*> strays_;  // items of shapes with clashing ids
+    QGraphicsRectItem* page_ = nullptr;
+    QGraphicsTextItem* emptyHint_ = nullptr;
+    bool updating_ = false;
+    std::vector<std::pair<QGraphicsItem*, QPointF>> dragStart_;  // selection when a drag began
+
+    QThreadPool decodePool_;
+    std::atomic<uint64_t> decodeGen_{0};  // bumped to invalidate pending decodes
+    std::unordered_set<PixmapCache::Key, PixmapCache::KeyHash> decoding_;
 };
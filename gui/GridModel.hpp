@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QPointF>
+
+#include <cmath>
+
+// The canvas grid, in scene units. Drawing and snap-to-grid both read it,
+// so the lines a shape snaps to are the lines on screen.
+struct GridModel
+{
+    int step = 25;
+    bool visible = false;
+    bool snap = false;
+
+    // Nearest grid line to `v`.
+    double snapped(double v) const { return std::round(v / step) * step; }
+
+    // `p` moved to the nearest grid point when snapping is on.
+    QPointF apply(const QPointF& p) const
+    {
+        if (!snap) return p;
+        return QPointF(snapped(p.x()), snapped(p.y()));
+    }
+};
@@ -4,6 +4,8 @@
 #include "gui/CanvasView.hpp"
 #include "gui/QtLogStream.hpp"
 #include "gui/SettingsDialog.hpp"
+#include "gui/PresenterWindow.hpp"
+#include "gui/PerfHud.hpp"
 
 #include <fstream>
 #include <iterator>
@@ -12,7 +14,8 @@
 
 #include <QApplication>
 #include <QLineEdit>
-#include <QTextEdit>
+#include <QPlainTextEdit>
+#include <QScrollBar>
 #include <QSplitter>
 #include <QVBoxLayout>
 #include <QWidget>
@@ -31,6 +34,10 @@
 #include <QPalette>
 #include <QImage>
 #include <QKeySequence>
+#include <QProgressBar>
+#include <QTimer>
+#include <QClipboard>
+#include <QElapsedTimer>
 
 #include <sstream>
 #include <iostream>
@@ -42,6 +49,8 @@
 #include "CommandParser.hpp"
 #include "ICommand.hpp"
 #include "Commands.hpp"
+#include "AsyncTask.hpp"
+#include "Profiler.hpp"
 #include "PPTXSerializer.hpp"
 #include "Functions.hpp"
 #include "SlideShow.hpp"
@@ -55,31 +64,62 @@ MainWindow::MainWindow(QWidget* parent)
     setupMenusAndToolbars();
     setupPropertiesDock();
 
-    logStream_ = new QtLogStream(this);
-    oldCout_ = std::cout.rdbuf(logStream_);
-    oldCerr_ = std::cerr.rdbuf(logStream_);
-
-    connect(logStream_, &QtLogStream::textReady,
-        this,
-        [this](const QString& line) { log_->append(line); },
-        Qt::QueuedConnection);
+    // Log lines are queued from any thread and appended to the panel in
+    // one batch per frame.
+    logQueue_ = new LogQueue(kLogMaxLines, this);
+    logFlushTimer_ = new QTimer(this);
+    logFlushTimer_->setSingleShot(true);
+    logFlushTimer_->setInterval(16);
+    connect(logFlushTimer_, &QTimer::timeout, this, &MainWindow::flushLog);
+    connect(logQueue_, &LogQueue::pending, logFlushTimer_, [this] {
+        if (!logFlushTimer_->isActive()) logFlushTimer_->start();
+    }, Qt::QueuedConnection);
+
+    // Logger output goes to the log panel instead of the console.
+    logSink_ = std::make_shared<QtLogSink>(logQueue_);
+    logging::removeSink(logging::consoleSink());
+    logging::addSink(logSink_);
 
     connect(canvas_, &CanvasView::shapeSelected, this, &MainWindow::onShapeSelected);
     connect(canvas_, &CanvasView::selectionCleared, this, &MainWindow::onSelectionCleared);
-    connect(canvas_, &CanvasView::shapeMoved, this, &MainWindow::onShapeMoved);
+    connect(canvas_, &CanvasView::shapesMoved, this, &MainWindow::onShapesMoved);
+
+    // Slide commands report their row changes as they run, so a sync only
+    // re-reads the slides that were touched.
+    Controller::instance().setSlideListener([this](const SlideEdit& edit) {
+        slideList_->applyEdit(edit);
+    });
 
     loadSettings();
     syncUiFromModel();
 
-    std::cout << "GUI started\n";
+    info() << "GUI started\n";
 }
 
 MainWindow::~MainWindow()
 {
+    finishAllTasks();
     saveSettings();
+    Controller::instance().setSlideListener(nullptr);
+
+    logging::removeSink(logSink_);
+    logging::addSink(logging::consoleSink());
+
+    prof::report(std::cerr);
+}
+
+void MainWindow::flushLog()
+{
+    size_t dropped = 0;
+    const QString text = logQueue_->take(&dropped);
+    if (dropped) log_->appendPlainText(QString("... %1 lines dropped").arg(qulonglong(dropped)));
+    if (text.isEmpty()) return;
 
-    if (oldCout_) std::cout.rdbuf(oldCout_);
-    if (oldCerr_) std::cerr.rdbuf(oldCerr_);
+    // Follow the output only if the user has not scrolled up.
+    QScrollBar* bar = log_->verticalScrollBar();
+    const bool atEnd = bar->value() == bar->maximum();
+    log_->appendPlainText(text);
+    if (atEnd) bar->setValue(bar->maximum());
 }
 
 void MainWindow::setupUi()
@@ -93,6 +133,8 @@ void MainWindow::setupUi()
 
     slideList_ = new SlideList;
     canvas_ = new CanvasView;
+    hud_ = new PerfHud(canvas_);
+    connect(canvas_, &CanvasView::framePainted, hud_, &PerfHud::addFrame);
 
     topSplitter->addWidget(slideList_);
     topSplitter->addWidget(canvas_);
@@ -102,8 +144,10 @@ void MainWindow::setupUi()
     commandInput_ = new QLineEdit;
     commandInput_->setPlaceholderText("Enter command... (help, open file.pptx, save out.pptx, goto 1, next, prev)");
 
-    log_ = new QTextEdit;
+    log_ = new QPlainTextEdit;
     log_->setReadOnly(true);
+    log_->setMaximumBlockCount(kLogMaxLines);
+    log_->setUndoRedoEnabled(false);
 
     root->addWidget(topSplitter, 4);
     root->addWidget(commandInput_);
@@ -114,6 +158,20 @@ void MainWindow::setupUi()
     connect(commandInput_, &QLineEdit::returnPressed, this, &MainWindow::onCommandEntered);
     connect(slideList_, &SlideList::slideChosen, this, &MainWindow::onSlideChosen);
 
+    taskProgress_ = new QProgressBar;
+    taskProgress_->setRange(0, 100);
+    taskProgress_->setMaximumWidth(200);
+    taskCancel_ = new QPushButton("Cancel");
+    statusBar()->addPermanentWidget(taskProgress_);
+    statusBar()->addPermanentWidget(taskCancel_);
+    taskProgress_->hide();
+    taskCancel_->hide();
+    connect(taskCancel_, &QPushButton::clicked, this, &MainWindow::cancelTask);
+
+    taskTimer_ = new QTimer(this);
+    taskTimer_->setInterval(50);
+    connect(taskTimer_, &QTimer::timeout, this, &MainWindow::pollTasks);
+
     statusBar()->showMessage("Ready");
 }
 
@@ -168,6 +226,22 @@ void MainWindow::setupMenusAndToolbars()
         canvas_->setShowGrid(on);
     });
 
+    QAction* frameOverlay = viewMenu->addAction("Show Frame Times");
+    frameOverlay->setCheckable(true);
+    connect(frameOverlay, &QAction::toggled, canvas_, &CanvasView::setFrameOverlay);
+
+    QAction* hudAction = viewMenu->addAction("Performance HUD");
+    hudAction->setCheckable(true);
+    hudAction->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_P));
+    connect(hudAction, &QAction::toggled, hud_, &QWidget::setVisible);
+
+    QAction* hudCopy = viewMenu->addAction("Copy Performance Stats");
+    connect(hudCopy, &QAction::triggered, this, [this] {
+        const QString text = hud_->report();
+        QApplication::clipboard()->setText(text);
+        info() << text.toStdString() << "\n";
+    });
+
     viewMenu->addSeparator();
     QAction* zoomIn = viewMenu->addAction("Zoom In");
     QAction* zoomOut = viewMenu->addAction("Zoom Out");
@@ -176,6 +250,11 @@ void MainWindow::setupMenusAndToolbars()
     connect(zoomOut, &QAction::triggered, canvas_, &CanvasView::zoomOut);
     connect(zoomReset, &QAction::triggered, canvas_, &CanvasView::zoomReset);
 
+    viewMenu->addSeparator();
+    QAction* present = viewMenu->addAction("Present");
+    present->setShortcut(QKeySequence(Qt::Key_F5));
+    connect(present, &QAction::triggered, this, &MainWindow::startPresentation);
+
     // ----- Tools
     QAction* settings = toolsMenu->addAction("Settings...");
     connect(settings, &QAction::triggered, this, &MainWindow::openSettings);
@@ -271,9 +350,15 @@ void MainWindow::loadSettings()
     QSettings st;
     darkMode_ = st.value("ui/darkMode", false).toBool();
     showGrid_ = st.value("ui/showGrid", false).toBool();
+    snapToGrid_ = st.value("ui/snapToGrid", false).toBool();
+    imageCacheMB_ = st.value("render/imageCacheMB", 256).toInt();
+    presentPrefetch_ = st.value("present/prefetch", 3).toInt();
+    presentBudgetMB_ = st.value("present/budgetMB", 384).toInt();
 
     if (darkModeAction_) darkModeAction_->setChecked(darkMode_);
     canvas_->setShowGrid(showGrid_);
+    canvas_->setSnapToGrid(snapToGrid_);
+    canvas_->imageCache().setBudget(size_t(std::max(0, imageCacheMB_)) << 20);
 
     toggleDarkMode(darkMode_);
 }
@@ -283,6 +368,10 @@ void MainWindow::saveSettings()
     QSettings st;
     st.setValue("ui/darkMode", darkMode_);
     st.setValue("ui/showGrid", showGrid_);
+    st.setValue("ui/snapToGrid", snapToGrid_);
+    st.setValue("render/imageCacheMB", imageCacheMB_);
+    st.setValue("present/prefetch", presentPrefetch_);
+    st.setValue("present/budgetMB", presentBudgetMB_);
 }
 
 void MainWindow::toggleDarkMode(bool enabled)
@@ -320,6 +409,8 @@ void MainWindow::openSettings()
 
     dlg.setDarkMode(darkMode_);
     dlg.setShowGrid(showGrid_);
+    dlg.setSnapToGrid(snapToGrid_);
+    dlg.setImageCacheMB(imageCacheMB_);
 
     auto& ctrl = Controller::instance();
     dlg.setAutosaveOnExit(ctrl.getAutoSaveOnExit());
@@ -330,6 +421,10 @@ void MainWindow::openSettings()
     if (darkModeAction_) darkModeAction_->setChecked(dlg.darkMode());
     showGrid_ = dlg.showGrid();
     canvas_->setShowGrid(showGrid_);
+    snapToGrid_ = dlg.snapToGrid();
+    canvas_->setSnapToGrid(snapToGrid_);
+    imageCacheMB_ = dlg.imageCacheMB();
+    canvas_->imageCache().setBudget(size_t(imageCacheMB_) << 20);
     ctrl.setAutoSaveOnExit(dlg.autosaveOnExit());
 
     syncUiFromModel();
@@ -366,6 +461,7 @@ void MainWindow::ensureSlide()
         ctrl.snapshot();
         ss.getSlides().push_back(Slide());
         ss.setCurrentIndex(0);
+        ctrl.notifySlides({SlideEdit::Kind::Insert, 0, 1});
         ctrl.rebuildUiIndex();
     }
 }
@@ -398,6 +494,7 @@ void MainWindow::addNewSlide()
     ctrl.snapshot();
     ss.getSlides().push_back(Slide());
     ss.setCurrentIndex(ss.getSlides().empty() ? 0 : ss.getSlides().size() - 1);
+    ctrl.notifySlides({SlideEdit::Kind::Insert, ss.getSlides().size() - 1, 1});
     ctrl.rebuildUiIndex();
     syncUiFromModel();
 }
@@ -409,7 +506,10 @@ void MainWindow::addTextShape()
     SlideShow& ss = ctrl.getCurrentSlideshow();
 
     ctrl.snapshot();
-    ss.getSlides()[ss.getCurrentIndex()].addShape(Shape("Text", 120, 120));
+    Shape sh("Text", 120, 120);
+    ctrl.getTextIndex().add(sh);
+    ss.getSlides()[ss.getCurrentIndex()].addShape(sh);
+    ctrl.notifySlides({SlideEdit::Kind::Change, ss.getCurrentIndex(), 1});
     ctrl.rebuildUiIndex();
     syncUiFromModel();
 }
@@ -423,7 +523,9 @@ void MainWindow::addRectShape()
     ctrl.snapshot();
     Shape sh("Rectangle", 150, 150, ShapeKind::Rect, 260, 120);
     sh.setText("Text");
+    ctrl.getTextIndex().add(sh);
     ss.getSlides()[ss.getCurrentIndex()].addShape(sh);
+    ctrl.notifySlides({SlideEdit::Kind::Change, ss.getCurrentIndex(), 1});
     ctrl.rebuildUiIndex();
     syncUiFromModel();
 }
@@ -437,7 +539,9 @@ void MainWindow::addEllipseShape()
     ctrl.snapshot();
     Shape sh("Ellipse", 180, 180, ShapeKind::Ellipse, 240, 140);
     sh.setText("Text");
+    ctrl.getTextIndex().add(sh);
     ss.getSlides()[ss.getCurrentIndex()].addShape(sh);
+    ctrl.notifySlides({SlideEdit::Kind::Change, ss.getCurrentIndex(), 1});
     ctrl.rebuildUiIndex();
     syncUiFromModel();
 }
@@ -473,7 +577,9 @@ sh.setW(w);
     }
 
     ctrl.snapshot();
+    ctrl.getTextIndex().add(sh);
     ss.getSlides()[ss.getCurrentIndex()].addShape(sh);
+    ctrl.notifySlides({SlideEdit::Kind::Change, ss.getCurrentIndex(), 1});
     ctrl.rebuildUiIndex();
     syncUiFromModel();
 }
@@ -481,7 +587,7 @@ sh.setW(w);
 void MainWindow::deleteSelectedShape()
 {
     if (selectedShape_ < 0) {
-        std::cout << "[ERR] No shape selected\n";
+        error() << "No shape selected\n";
         return;
     }
     // CLI ids are 1-based.
@@ -491,7 +597,7 @@ void MainWindow::deleteSelectedShape()
 void MainWindow::duplicateSelectedShape()
 {
     if (selectedShape_ < 0) {
-        std::cout << "[ERR] No shape selected\n";
+        error() << "No shape selected\n";
         return;
     }
     executeCommand(QString("duplicate shape %1").arg(selectedShape_ + 1), true);
@@ -522,20 +628,34 @@ void MainWindow::onSlideChosen(int index)
 
 bool MainWindow::executeCommand(const QString& cmd, bool echoToLog)
 {
-    if (echoToLog) log_->append("> " + cmd);
+    if (echoToLog) logQueue_->push("> " + cmd);
+
+    QElapsedTimer actionTimer;
+    actionTimer.start();
 
     std::istringstream in(cmd.toStdString());
     std::unique_ptr<ICommand> icmd = CommandParser::parse(in);
     if (!icmd) {
-        std::cout << "[ERR] Invalid command\n";
+        error() << "Invalid command\n";
         return false;
     }
 
     auto& ctrl = Controller::instance();
 
+    // File operations stay ordered, as in the CLI: a new open/save first
+    // finishes the ones still running (a save may be writing the file about
+    // to be opened).
+    auto* async = dynamic_cast<IAsyncCommand*>(icmd.get());
+    if (async && !tasks_.empty()) {
+        statusBar()->showMessage("Waiting for " + QString::fromStdString(tasks_.front()->label()) + "...");
+        finishAllTasks();
+        pollTasks();
+        ctrl.rebuildUiIndex();
+        syncUiFromModel();
+    }
+
     bool shouldSnapshot =
         dynamic_cast<CommandCreateSlideshow*>(icmd.get()) ||
-        dynamic_cast<CommandOpen*>(icmd.get()) ||
         dynamic_cast<CommandAddSlide*>(icmd.get()) ||
         dynamic_cast<CommandRemoveSlide*>(icmd.get()) ||
         dynamic_cast<CommandMoveSlide*>(icmd.get()) ||
@@ -550,18 +670,93 @@ bool MainWindow::executeCommand(const QString& cmd, bool echoToLog)
         dynamic_cast<CommandMoveShape*>(icmd.get()) ||
         dynamic_cast<CommandResizeShape*>(icmd.get()) ||
         dynamic_cast<CommandSetShapeText*>(icmd.get()) ||
-        dynamic_cast<CommandDuplicateShape*>(icmd.get());
+        dynamic_cast<CommandDuplicateShape*>(icmd.get()) ||
+        dynamic_cast<CommandPlayMacro*>(icmd.get()) ||
+        dynamic_cast<CommandGenerateDeck*>(icmd.get());
 
     if (shouldSnapshot) ctrl.snapshot();
 
-    icmd->execute();
+    if (async) {
+        if (auto task = async->startAsync()) startTask(std::move(task));
+        return true;
+    }
+
+    {
+        PROFILE_SCOPE(prof::Phase::Execute);
+        icmd->execute();
+    }
 
     ctrl.rebuildUiIndex();
     syncUiFromModel();
+    hud_->setLastAction(cmd, actionTimer.nsecsElapsed(), lastSyncNs_, lastRenderNs_);
     return true;
 }
 
+void MainWindow::startTask(std::shared_ptr<AsyncTask> task)
+{
+    statusBar()->showMessage(QString::fromStdString(task->label()) + "...");
+    tasks_.push_back(std::move(task));
+    taskProgress_->setValue(0);
+    taskProgress_->show();
+    taskCancel_->show();
+    if (!taskTimer_->isActive()) taskTimer_->start();
+}
+
+void MainWindow::pollTasks()
+{
+    bool finished = false;
+    for (auto it = tasks_.begin(); it != tasks_.end();) {
+        if ((*it)->isReady()) {
+            (*it)->complete();
+            it = tasks_.erase(it);
+            finished = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (finished) {
+        Controller::instance().rebuildUiIndex();
+        syncUiFromModel();
+    }
+
+    if (tasks_.empty()) {
+        taskTimer_->stop();
+        taskProgress_->hide();
+        taskCancel_->hide();
+        statusBar()->showMessage("Ready");
+        return;
+    }
+
+    const AsyncTask& current = *tasks_.front();
+    taskProgress_->setValue(current.progressPercent());
+    statusBar()->showMessage(QString::fromStdString(current.label()) + "...");
+}
+
+void MainWindow::cancelTask()
+{
+    if (!tasks_.empty()) tasks_.front()->cancel();
+}
+
+void MainWindow::finishAllTasks()
+{
+    for (auto& t : tasks_) t->complete();
+    tasks_.clear();
+}
+
 void MainWindow::syncUiFromModel()
+{
+    QElapsedTimer timer;
+    timer.start();
+    syncViews();
+
+    // executeCommand() reports these together with its own total.
+    lastSyncNs_ = timer.nsecsElapsed();
+    lastRenderNs_ = canvas_->takeRenderNs();
+    hud_->setLastAction("sync", -1, lastSyncNs_, lastRenderNs_);
+}
+
+void MainWindow::syncViews()
 {
     auto& ctrl = Controller::instance();
 
@@ -577,7 +772,7 @@ void MainWindow::syncUiFromModel()
     const int count = static_cast<int>(slides.size());
     const int cur = (count > 0) ? static_cast<int>(ss.getCurrentIndex()) : 0;
 
-    slideList_->setSlideCount(count, cur);
+    slideList_->setSlides(slides, cur);
 
     if (slides.empty()) {
         canvas_->showMessage("Empty presentation.\nUse toolbar: New Slide");
@@ -591,6 +786,34 @@ void MainWindow::syncUiFromModel()
     }
 }
 
+void MainWindow::startPresentation()
+{
+    auto& ctrl = Controller::instance();
+    if (ctrl.getSlideshows().empty() || ctrl.getCurrentSlideshow().getSlides().empty()) {
+        error() << "Nothing to present\n";
+        return;
+    }
+    // A finishing open would replace the slides under the presenter.
+    if (!tasks_.empty()) {
+        error() << "Wait for the running task to finish\n";
+        return;
+    }
+
+    SlideShow& ss = ctrl.getCurrentSlideshow();
+    auto* presenter = new PresenterWindow(ss.getSlides(), static_cast<int>(ss.getCurrentIndex()),
+                                          presentPrefetch_, size_t(std::max(0, presentBudgetMB_)) << 20,
+                                          this);
+    // Come back to the slide the presentation ended on.
+    connect(presenter, &PresenterWindow::finished, this, [this](int index) {
+        auto& ctrl = Controller::instance();
+        if (ctrl.getSlideshows().empty()) return;
+        SlideShow& ss = ctrl.getCurrentSlideshow();
+        if (index >= 0 && (size_t)index < ss.getSlides().size()) ss.setCurrentIndex((size_t)index);
+        syncUiFromModel();
+    });
+    presenter->showFullScreen();
+}
+
 void MainWindow::onShapeSelected(int idx)
 {
     selectedShape_ = idx;
@@ -631,7 +854,7 @@ void MainWindow::onSelectionCleared()
     textEdit_->setText("");
 }
 
-void MainWindow::onShapeMoved(int idx, int x, int y)
+void MainWindow::onShapesMoved(const QVector<ShapeMove>& moves)
 {
     auto& ctrl = Controller::instance();
     if (ctrl.getSlideshows().empty()) return;
@@ -641,18 +864,22 @@ void MainWindow::onShapeMoved(int idx, int x, int y)
 
     auto& slide = ss.getSlides()[ss.getCurrentIndex()];
     auto& shapes = slide.getShapes();
-    if (idx < 0 || (size_t)idx >= shapes.size()) return;
 
-    // Record one snapshot per drag, so undo works the way the user expects.
+    // One snapshot and one re-render per drag, however many shapes moved,
+    // so undo puts the whole group back.
     ctrl.snapshot();
 
-    Shape& sh = shapes[(size_t)idx];
-    sh.setX(x);
-    sh.setY(y);
+    for (const ShapeMove& m : moves) {
+        if (m.index < 0 || (size_t)m.index >= shapes.size()) continue;
+        Shape& sh = shapes[(size_t)m.index];
+        sh.setX(m.x);
+        sh.setY(m.y);
+    }
+    ctrl.notifySlides({SlideEdit::Kind::Change, ss.getCurrentIndex(), 1});
 
     ctrl.rebuildUiIndex();
     syncUiFromModel();
-    onShapeSelected(idx);
+    if (selectedShape_ >= 0) onShapeSelected(selectedShape_);
 }
 
 void MainWindow::applyShapeProperties()
@@ -677,6 +904,8 @@ void MainWindow::applyShapeProperties()
     sh.setW(wSpin_->value());
     sh.setH(hSpin_->value());
     sh.setText(textEdit_->text().toStdString());
+    ctrl.getTextIndex().update(sh);
+    ctrl.notifySlides({SlideEdit::Kind::Change, ss.getCurrentIndex(), 1});
 
     ctrl.rebuildUiIndex();
     syncUiFromModel();
@@ -684,13 +913,15 @@ void MainWindow::applyShapeProperties()
 
 void MainWindow::closeEvent(QCloseEvent* e)
 {
+    finishAllTasks();
+
     auto& ctrl = Controller::instance();
 
     if (ctrl.getAutoSaveOnExit() && !ctrl.getSlideshows().empty()) {
         std::string desired = ctrl.getCurrentSlideshow().getFilename();
         if (desired.empty()) desired = "AutoExport.pptx";
         const std::string file = utils::makeUniquePptxPath(desired);
-        std::cout << "Autosaving to " << file << "\n";
+        info() << "Autosaving to " << file << "\n";
         PPTXSerializer::save(ctrl.getSlideshows(), ctrl.getPresentationOrder(), file);
     }
 
@@ -1,13 +1,19 @@
 #pragma once
 
+#include "gui/CanvasView.hpp"  // ShapeMove, used in a slot signature
+
 #include <QMainWindow>
 
+#include <memory>
+#include <vector>
+
 class SlideList;
-class CanvasView;
-class QtLogStream;
+class QtLogSink;
+class LogQueue;
+class PerfHud;
 
 class QLineEdit;
-class QTextEdit;
+class QPlainTextEdit;
 class QAction;
 
 class QDockWidget;
@@ -15,6 +21,10 @@ class QSpinBox;
 class QLineEdit;
 class QPushButton;
 class QLabel;
+class QProgressBar;
+class QTimer;
+
+class AsyncTask;
 
 class MainWindow : public QMainWindow
 {
@@ -49,13 +59,19 @@ private slots:
     void toggleDarkMode(bool enabled);
     void openSettings();
     void showHelp();
+    void startPresentation();
     void about();
 
     void onShapeSelected(int idx);
     void onSelectionCleared();
     void applyShapeProperties();
 
-    void onShapeMoved(int idx, int x, int y);
+    void onShapesMoved(const QVector<ShapeMove>& moves);
+
+    void pollTasks();
+    void cancelTask();
+
+    void flushLog();
 
 private:
     void setupUi();
@@ -66,10 +82,14 @@ private:
     void saveSettings();
 
     void syncUiFromModel();
+    void syncViews();
     bool executeCommand(const QString& cmd, bool echoToLog = false);
 
     QString quoteIfNeeded(const QString& s) const;
 
+    void startTask(std::shared_ptr<AsyncTask> task);
+    void finishAllTasks();
+
     void ensurePresentation();
     void ensureSlide();
 
@@ -77,16 +97,27 @@ private:
     SlideList* slideList_ = nullptr;
     CanvasView* canvas_ = nullptr;
     QLineEdit* commandInput_ = nullptr;
-    QTextEdit* log_ = nullptr;
+    QPlainTextEdit* log_ = nullptr;
 
-    QtLogStream* logStream_ = nullptr;
-    std::streambuf* oldCout_ = nullptr;
-    std::streambuf* oldCerr_ = nullptr;
+    // Lines kept in the log panel (and pending for it).
+    static constexpr int kLogMaxLines = 200000;
+    LogQueue* logQueue_ = nullptr;
+    QTimer* logFlushTimer_ = nullptr;
+    std::shared_ptr<QtLogSink> logSink_;
 
     QAction* darkModeAction_ = nullptr;
 
+    // Frame times, event-loop latency and the cost of the last action.
+    PerfHud* hud_ = nullptr;
+    qint64 lastSyncNs_ = -1;
+    qint64 lastRenderNs_ = -1;
+
     bool darkMode_ = false;
     bool showGrid_ = false;
+    bool snapToGrid_ = false;
+    int imageCacheMB_ = 256;
+    int presentPrefetch_ = 3;     // slides pre-rendered each way when presenting
+    int presentBudgetMB_ = 384;   // cap on those pre-rendered frames
 
     QDockWidget* propsDock_ = nullptr;
     QLabel* selLabel_ = nullptr;
@@ -98,4 +129,11 @@ private:
     QPushButton* applyBtn_ = nullptr;
 
     int selectedShape_ = -1;
+
+    // Open/save running on worker threads; polled from the event loop and
+    // completed here, on the GUI (model) thread.
+    std::vector<std::shared_ptr<AsyncTask>> tasks_;
+    QTimer* taskTimer_ = nullptr;
+    QProgressBar* taskProgress_ = nullptr;
+    QPushButton* taskCancel_ = nullptr;
 };
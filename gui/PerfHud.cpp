@@ -0,0 +1,152 @@
+#include "gui/PerfHud.hpp"
+
+#include <QEvent>
+#include <QFont>
+#include <QFontDatabase>
+#include <QPainter>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+
+constexpr qint64 kFrameBudgetNs = 16'666'667;  // 60 Hz
+constexpr int kGraphH = 44;
+constexpr int kMargin = 8;
+
+QString ms(qint64 ns)
+{
+    if (ns < 0) return "-";
+    return QString::number(ns / 1e6, 'f', 2) + " ms";
+}
+
+} // namespace
+
+PerfHud::PerfHud(QWidget* host)
+    : QWidget(host)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    // Opaque, so repainting the HUD never repaints what is under it.
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFixedSize(320, 136);
+    hide();
+
+    ticker_ = new QTimer(this);
+    ticker_->setTimerType(Qt::PreciseTimer);
+    ticker_->setInterval(kTickMs);
+    connect(ticker_, &QTimer::timeout, this, &PerfHud::tick);
+
+    host->installEventFilter(this);
+}
+
+void PerfHud::addFrame(qint64 ns)
+{
+    frames_[(size_t)frameHead_] = ns;
+    frameHead_ = (frameHead_ + 1) % kFrames;
+    frameCount_ = std::min(frameCount_ + 1, kFrames);
+}
+
+void PerfHud::setLastAction(const QString& what, qint64 execNs, qint64 syncNs, qint64 renderNs)
+{
+    action_ = what;
+    execNs_ = execNs;
+    syncNs_ = syncNs;
+    renderNs_ = renderNs;
+}
+
+QString PerfHud::report() const
+{
+    qint64 last = 0, sum = 0, worst = 0;
+    for (int i = 0; i < frameCount_; ++i) {
+        const qint64 ns = frames_[(size_t)((frameHead_ - 1 - i + kFrames) % kFrames)];
+        if (i == 0) last = ns;
+        sum += ns;
+        worst = std::max(worst, ns);
+    }
+    const qint64 avg = frameCount_ ? sum / frameCount_ : 0;
+
+    QString out;
+    out += QString("frames (%1): last %2, avg %3, max %4\n")
+               .arg(frameCount_).arg(ms(last), ms(avg), ms(worst));
+    out += QString("event loop latency: %1 (max %2 over 1 s)\n")
+               .arg(ms(lastLatencyNs_), ms(maxLatencyNs_));
+    out += QString("last action: %1\n").arg(action_.isEmpty() ? QString("-") : action_);
+    out += QString("  execute %1, sync %2, render %3")
+               .arg(ms(execNs_), ms(syncNs_), ms(renderNs_));
+    return out;
+}
+
+void PerfHud::tick()
+{
+    const qint64 late = sinceTick_.nsecsElapsed() - qint64(kTickMs) * 1'000'000;
+    sinceTick_.restart();
+    lastLatencyNs_ = std::max<qint64>(0, late);
+    windowMaxNs_ = std::max(windowMaxNs_, lastLatencyNs_);
+    if (++ticksInWindow_ >= 1000 / kTickMs) {
+        maxLatencyNs_ = windowMaxNs_;
+        windowMaxNs_ = 0;
+        ticksInWindow_ = 0;
+    }
+    update();
+}
+
+void PerfHud::paintEvent(QPaintEvent*)
+{
+    QPainter p(this);
+    p.fillRect(rect(), QColor(24, 24, 24));
+
+    QFont f = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    f.setPointSize(8);
+    p.setFont(f);
+    p.setPen(QColor(230, 230, 230));
+    const QRect textRect(kMargin, kMargin / 2, width() - 2 * kMargin, height() - kGraphH - kMargin);
+    p.drawText(textRect, Qt::AlignLeft | Qt::AlignTop, report());
+
+    // Frame time bars, oldest on the left; the line marks a 60 Hz frame.
+    const QRect graph(kMargin, height() - kGraphH - kMargin / 2, width() - 2 * kMargin, kGraphH);
+    p.fillRect(graph, QColor(40, 40, 40));
+
+    qint64 scale = 2 * kFrameBudgetNs;
+    for (int i = 0; i < frameCount_; ++i) scale = std::max(scale, frames_[(size_t)i]);
+
+    const double barW = double(graph.width()) / kFrames;
+    for (int i = 0; i < frameCount_; ++i) {
+        const int slot = kFrames - frameCount_ + i;
+        const qint64 ns = frames_[(size_t)((frameHead_ - frameCount_ + i + kFrames) % kFrames)];
+        const int h = std::max(1, int(double(ns) / scale * graph.height()));
+        const QColor c = ns <= kFrameBudgetNs ? QColor(90, 190, 90)
+                       : ns <= 2 * kFrameBudgetNs ? QColor(230, 170, 60)
+                       : QColor(220, 70, 70);
+        p.fillRect(QRectF(graph.left() + slot * barW, graph.bottom() + 1 - h, std::max(1.0, barW - 1), h), c);
+    }
+
+    const int budgetY = graph.bottom() + 1 - int(double(kFrameBudgetNs) / scale * graph.height());
+    p.setPen(QColor(200, 200, 90));
+    p.drawLine(graph.left(), budgetY, graph.right(), budgetY);
+}
+
+bool PerfHud::eventFilter(QObject* watched, QEvent* e)
+{
+    if (watched == parentWidget() && e->type() == QEvent::Resize) reposition();
+    return QWidget::eventFilter(watched, e);
+}
+
+void PerfHud::showEvent(QShowEvent* e)
+{
+    QWidget::showEvent(e);
+    reposition();
+    raise();
+    sinceTick_.start();
+    ticker_->start();
+}
+
+void PerfHud::hideEvent(QHideEvent* e)
+{
+    ticker_->stop();
+    QWidget::hideEvent(e);
+}
+
+void PerfHud::reposition()
+{
+    // Leave room for the host's vertical scroll bar.
+    move(std::max(0, parentWidget()->width() - width() - 3 * kMargin), kMargin);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QWidget>
+
+#include <array>
+#include <cstdint>
+
+class QTimer;
+
+// Performance overlay pinned to the top-right corner of `host`: recent
+// canvas frame times, event-loop latency and where the last action spent
+// its time. report() gives the same numbers as text for bug reports.
+class PerfHud : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit PerfHud(QWidget* host);
+
+    void addFrame(qint64 ns);
+    // `execNs` is -1 for actions that did not run a command.
+    void setLastAction(const QString& what, qint64 execNs, qint64 syncNs, qint64 renderNs);
+
+    QString report() const;
+
+protected:
+    void paintEvent(QPaintEvent* e) override;
+    bool eventFilter(QObject* watched, QEvent* e) override;
+    void showEvent(QShowEvent* e) override;
+    void hideEvent(QHideEvent* e) override;
+
+private:
+    void tick();
+    void reposition();
+
+    static constexpr int kFrames = 120;
+    std::array<qint64, kFrames> frames_{};  // ring buffer, ns
+    int frameHead_ = 0;
+    int frameCount_ = 0;
+
+    // The tick timer fires every kTickMs; how late it runs is the time the
+    // event loop was busy with something else.
+    static constexpr int kTickMs = 50;
+    QTimer* ticker_ = nullptr;
+    QElapsedTimer sinceTick_;
+    qint64 lastLatencyNs_ = 0;
+    qint64 maxLatencyNs_ = 0;   // over the last second
+    qint64 windowMaxNs_ = 0;
+    int ticksInWindow_ = 0;
+
+    QString action_;
+    qint64 execNs_ = -1;
+    qint64 syncNs_ = -1;
+    qint64 renderNs_ = -1;
+};
@@ -0,0 +1,92 @@
+#include "gui/PixmapCache.hpp"
+
+namespace {
+
+size_t costOf(const QPixmap& pm)
+{
+    const int depth = pm.depth() > 0 ? pm.depth() : 32;
+    return size_t(pm.width()) * size_t(pm.height()) * size_t(depth) / 8;
+}
+
+inline void mix(size_t& h, uint64_t v)
+{
+    h ^= static_cast<size_t>(v) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+}
+
+} // namespace
+
+bool PixmapCache::Key::operator==(const Key& o) const
+{
+    return hash == o.hash && bytes == o.bytes &&
+           cropL == o.cropL && cropT == o.cropT && cropR == o.cropR && cropB == o.cropB &&
+           width == o.width && height == o.height;
+}
+
+size_t PixmapCache::KeyHash::operator()(const Key& k) const
+{
+    size_t h = static_cast<size_t>(k.hash);
+    mix(h, k.bytes);
+    mix(h, (uint64_t(uint32_t(k.cropL)) << 32) | uint32_t(k.cropT));
+    mix(h, (uint64_t(uint32_t(k.cropR)) << 32) | uint32_t(k.cropB));
+    mix(h, (uint64_t(uint32_t(k.width)) << 32) | uint32_t(k.height));
+    return h;
+}
+
+PixmapCache::PixmapCache(size_t budgetBytes)
+    : budget_(budgetBytes)
+{
+}
+
+QPixmap PixmapCache::find(const Key& key)
+{
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++misses_;
+        return QPixmap();
+    }
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->pixmap;
+}
+
+void PixmapCache::insert(const Key& key, const QPixmap& pm)
+{
+    const size_t cost = costOf(pm);
+    // An image larger than the whole budget would only evict everything else.
+    if (cost > budget_) return;
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        used_ -= it->second->cost;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    lru_.push_front({key, pm, cost});
+    index_.emplace(key, lru_.begin());
+    used_ += cost;
+    evict();
+}
+
+void PixmapCache::setBudget(size_t bytes)
+{
+    budget_ = bytes;
+    evict();
+}
+
+void PixmapCache::clear()
+{
+    lru_.clear();
+    index_.clear();
+    used_ = 0;
+}
+
+void PixmapCache::evict()
+{
+    while (used_ > budget_ && !lru_.empty()) {
+        const Entry& e = lru_.back();
+        used_ -= e.cost;
+        index_.erase(e.key);
+        lru_.pop_back();
+    }
+}
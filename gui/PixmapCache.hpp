@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QPixmap>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+// Decoded, cropped and scaled images ready for the canvas, so re-rendering
+// an unchanged slide does no image decoding. Least recently used entries
+// are evicted once the pixel memory exceeds the budget.
+class PixmapCache
+{
+public:
+    struct Key
+    {
+        uint64_t hash = 0;   // Shape::getImageHash()
+        size_t bytes = 0;    // encoded size, disambiguates hash collisions
+        int cropL = 0, cropT = 0, cropR = 0, cropB = 0;
+        int width = 0, height = 0;
+
+        bool operator==(const Key& o) const;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const;
+    };
+
+    explicit PixmapCache(size_t budgetBytes = size_t(256) << 20);
+
+    // Null pixmap on a miss.
+    QPixmap find(const Key& key);
+    void insert(const Key& key, const QPixmap& pm);
+
+    void setBudget(size_t bytes);
+    size_t budget() const { return budget_; }
+    size_t usedBytes() const { return used_; }
+    void clear();
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    struct Entry
+    {
+        Key key;
+        QPixmap pixmap;
+        size_t cost;
+    };
+
+    void evict();
+
+    std::list<Entry> lru_;  // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    size_t budget_;
+    size_t used_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
@@ -0,0 +1,210 @@
+#include "gui/PresenterWindow.hpp"
+#include "gui/SlideRenderer.hpp"
+
+#include "Slide.hpp"
+
+#include <QCloseEvent>
+#include <QImage>
+#include <QKeyEvent>
+#include <QMetaObject>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QThread>
+#include <algorithm>
+#include <cstdlib>
+
+PresenterWindow::PresenterWindow(const std::vector<::Slide>& slides, int start,
+                                 int prefetch, size_t budgetBytes, QWidget* parent)
+    : QWidget(parent, Qt::Window | Qt::FramelessWindowHint),
+      slides_(slides),
+      prefetch_(std::max(0, prefetch)),
+      budget_(budgetBytes)
+{
+    current_ = slides_.empty() ? 0 : std::clamp(start, 0, (int)slides_.size() - 1);
+
+    setAttribute(Qt::WA_DeleteOnClose);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setWindowModality(Qt::ApplicationModal);
+    setFocusPolicy(Qt::StrongFocus);
+    setCursor(Qt::BlankCursor);
+
+    // Leave a core for the GUI thread.
+    pool_.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+PresenterWindow::~PresenterWindow()
+{
+    // Workers post results to this object; none may be running past here.
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.clear();
+    }
+    pool_.clear();
+    pool_.waitForDone();
+}
+
+int PresenterWindow::reach() const
+{
+    const size_t frameBytes = size_t(frameSize_.width()) * size_t(frameSize_.height()) * 4;
+    if (frameBytes == 0) return prefetch_;
+    // The current frame always stays; the rest is split evenly both ways.
+    const size_t frames = budget_ / frameBytes;
+    const int fit = frames > 1 ? int((frames - 1) / 2) : 0;
+    return std::min(prefetch_, fit);
+}
+
+void PresenterWindow::go(int index)
+{
+    if (slides_.empty()) return;
+    index = std::clamp(index, 0, (int)slides_.size() - 1);
+    if (index == current_) return;
+    current_ = index;
+    prefetch();
+    update();
+}
+
+void PresenterWindow::prefetch()
+{
+    if (frameSize_.isEmpty() || slides_.empty()) return;
+
+    const int k = reach();
+    const int lo = std::max(0, current_ - k);
+    const int hi = std::min((int)slides_.size() - 1, current_ + k);
+    auto inWindow = [lo, hi](int i) { return i >= lo && i <= hi; };
+
+    for (auto it = frames_.begin(); it != frames_.end();) {
+        if (inWindow(it->first)) ++it;
+        else it = frames_.erase(it);
+    }
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (inWindow(*it)) ++it;
+            else it = pending_.erase(it);
+        }
+    }
+
+    // Current slide first, then outwards; nearer slides get higher priority.
+    std::vector<int> order{current_};
+    for (int d = 1; d <= k; ++d) {
+        order.push_back(current_ + d);
+        order.push_back(current_ - d);
+    }
+
+    for (int idx : order) {
+        if (!inWindow(idx) || frames_.count(idx)) continue;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+            if (!pending_.insert(idx).second) continue;
+        }
+
+        // The slides stay put while presenting (see the header) and the
+        // destructor waits for the pool, so workers read them in place.
+        const ::Slide* slide = &slides_[(size_t)idx];
+        const QSize size = frameSize_;
+        pool_.start([this, idx, slide, size]() {
+            {
+                std::lock_guard<std::mutex> lock(pendingMutex_);
+                if (!pending_.count(idx)) return;  // left the window
+            }
+            QImage img = render::slideImage(*slide, size);
+            QMetaObject::invokeMethod(this, [this, idx, size, img = std::move(img)]() {
+                frameReady(idx, size, img);
+            }, Qt::QueuedConnection);
+        }, k - std::abs(idx - current_));
+    }
+}
+
+void PresenterWindow::frameReady(int index, const QSize& size, const QImage& img)
+{
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.erase(index);
+    }
+    // Rendered for another screen size, or no longer near the current slide.
+    if (size != frameSize_ || std::abs(index - current_) > reach()) return;
+
+    QPixmap pm = QPixmap::fromImage(img);
+    pm.setDevicePixelRatio(devicePixelRatioF());
+    frames_[index] = std::move(pm);
+    if (index == current_) update();
+}
+
+void PresenterWindow::paintEvent(QPaintEvent*)
+{
+    QPainter p(this);
+    p.fillRect(rect(), Qt::black);
+
+    // Until the current frame arrives the previous one stays up.
+    auto it = frames_.find(current_);
+    if (it != frames_.end()) shown_ = it->second;
+    if (shown_.isNull()) return;
+
+    const QSizeF s = shown_.deviceIndependentSize();
+    p.drawPixmap(QPointF((width() - s.width()) / 2, (height() - s.height()) / 2), shown_);
+}
+
+void PresenterWindow::resizeEvent(QResizeEvent* e)
+{
+    QWidget::resizeEvent(e);
+
+    QSize frame(render::kSlideW, render::kSlideH);
+    frame.scale(size() * devicePixelRatioF(), Qt::KeepAspectRatio);
+    if (frame == frameSize_) return;
+
+    frameSize_ = frame;
+    frames_.clear();
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.clear();
+    }
+    pool_.clear();
+    prefetch();
+}
+
+void PresenterWindow::keyPressEvent(QKeyEvent* e)
+{
+    switch (e->key()) {
+    case Qt::Key_Right:
+    case Qt::Key_Down:
+    case Qt::Key_PageDown:
+    case Qt::Key_Space:
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+    case Qt::Key_N:
+        go(current_ + 1);
+        break;
+    case Qt::Key_Left:
+    case Qt::Key_Up:
+    case Qt::Key_PageUp:
+    case Qt::Key_Backspace:
+    case Qt::Key_P:
+        go(current_ - 1);
+        break;
+    case Qt::Key_Home:
+        go(0);
+        break;
+    case Qt::Key_End:
+        go((int)slides_.size() - 1);
+        break;
+    case Qt::Key_Escape:
+    case Qt::Key_Q:
+        close();
+        break;
+    default:
+        QWidget::keyPressEvent(e);
+    }
+}
+
+void PresenterWindow::mousePressEvent(QMouseEvent* e)
+{
+    if (e->button() == Qt::LeftButton) go(current_ + 1);
+    else if (e->button() == Qt::RightButton) go(current_ - 1);
+    else QWidget::mousePressEvent(e);
+}
+
+void PresenterWindow::closeEvent(QCloseEvent* e)
+{
+    emit finished(current_);
+    QWidget::closeEvent(e);
+}
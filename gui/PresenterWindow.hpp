@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QPixmap>
+#include <QSize>
+#include <QThreadPool>
+#include <QWidget>
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class QImage;
+class Slide;
+
+// Full-screen slide playback. Slides are rendered at screen resolution on a
+// worker pool ahead of time: the current one plus `prefetch` on either side,
+// fewer if that would exceed the memory budget. Changing slides then only
+// blits a finished frame.
+class PresenterWindow : public QWidget
+{
+    Q_OBJECT
+public:
+    // `slides` belongs to the session and must not change while presenting
+    // (the window is application-modal).
+    PresenterWindow(const std::vector<::Slide>& slides, int start,
+                    int prefetch, size_t budgetBytes, QWidget* parent = nullptr);
+    ~PresenterWindow() override;
+
+    int currentIndex() const { return current_; }
+
+signals:
+    // The window closed on slide `index`.
+    void finished(int index);
+
+protected:
+    void paintEvent(QPaintEvent* e) override;
+    void resizeEvent(QResizeEvent* e) override;
+    void keyPressEvent(QKeyEvent* e) override;
+    void mousePressEvent(QMouseEvent* e) override;
+    void closeEvent(QCloseEvent* e) override;
+
+private:
+    void go(int index);
+    // Drops frames outside the window around the current slide and queues
+    // the missing ones, nearest first.
+    void prefetch();
+    int reach() const;
+    void frameReady(int index, const QSize& size, const QImage& img);
+
+    const std::vector<::Slide>& slides_;
+    int current_ = 0;
+    int prefetch_;
+    size_t budget_;
+
+    QSize frameSize_;                           // device pixels
+    std::unordered_map<int, QPixmap> frames_;   // by slide index
+    QPixmap shown_;                             // last frame painted
+
+    QThreadPool pool_;
+    // Slides queued or rendering; a worker skips a slide removed from here.
+    std::mutex pendingMutex_;
+    std::unordered_set<int> pending_;
+};
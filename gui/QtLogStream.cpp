@@ -1,33 +1,80 @@
 #include "gui/QtLogStream.hpp"
 
-QtLogStream::QtLogStream(QObject* parent)
-    : QObject(parent)
+#include <utility>
+
+namespace {
+
+// Calls fn(line) for each non-empty line of `text`, without '\r'.
+template <class Fn>
+void forEachLine(std::string_view text, Fn fn)
 {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t nl = text.find('\n', start);
+        if (nl == std::string_view::npos) nl = text.size();
+        size_t end = nl;
+        if (end > start && text[end - 1] == '\r') --end;
+        if (end > start) fn(text.substr(start, end - start));
+        start = nl + 1;
+    }
 }
 
-int QtLogStream::overflow(int ch)
+} // namespace
+
+LogQueue::LogQueue(size_t capacity, QObject* parent)
+    : QObject(parent), ring_(capacity ? capacity : 1)
 {
-    if (ch == traits_type::eof())
-        return traits_type::not_eof(ch);
+}
 
-    const QChar qc(static_cast<char>(ch));
+void LogQueue::push(QString line)
+{
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wasEmpty = count_ == 0;
+        if (count_ == ring_.size()) {
+            ring_[head_] = std::move(line);
+            head_ = (head_ + 1) % ring_.size();
+            ++dropped_;
+        } else {
+            ring_[(head_ + count_) % ring_.size()] = std::move(line);
+            ++count_;
+        }
+    }
+    if (wasEmpty) emit pending();
+}
+
+QString LogQueue::take(size_t* dropped)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    qsizetype chars = 0;
+    for (size_t i = 0; i < count_; ++i) chars += ring_[(head_ + i) % ring_.size()].size() + 1;
 
-    if (qc == '\n') {
-        if (!buffer_.isEmpty())
-            emit textReady(buffer_);
-        buffer_.clear();
-    } else if (qc != '\r') {
-        buffer_.append(qc);
+    QString text;
+    text.reserve(chars);
+    for (size_t i = 0; i < count_; ++i) {
+        QString& line = ring_[(head_ + i) % ring_.size()];
+        if (i) text += '\n';
+        text += line;
+        line = QString();
     }
+    head_ = 0;
+    count_ = 0;
+    if (dropped) *dropped = dropped_;
+    dropped_ = 0;
+    return text;
+}
 
-    return ch;
+QtLogSink::QtLogSink(LogQueue* queue)
+    : queue_(queue)
+{
 }
 
-int QtLogStream::sync()
+void QtLogSink::write(logging::Level level, std::string_view text)
 {
-    if (!buffer_.isEmpty()) {
-        emit textReady(buffer_);
-        buffer_.clear();
-    }
-    return 0;
+    QString prefix = QString::fromLatin1(logging::tag(level));
+    forEachLine(text, [&](std::string_view line) {
+        queue_->push(prefix + QString::fromUtf8(line.data(), qsizetype(line.size())));
+        prefix.clear();
+    });
 }
@@ -1,22 +1,49 @@
 #pragma once
 
+#include "Log.hpp"
+
 #include <QObject>
 #include <QString>
-#include <streambuf>
 
-class QtLogStream : public QObject, public std::streambuf
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Lines waiting for the log panel. Any thread may push; the GUI thread
+// takes everything pending once per frame. A fixed-size ring: when
+// producers outrun the panel the oldest pending lines are overwritten and
+// counted as dropped.
+class LogQueue : public QObject
 {
     Q_OBJECT
 public:
-    explicit QtLogStream(QObject* parent = nullptr);
+    explicit LogQueue(size_t capacity, QObject* parent = nullptr);
+
+    void push(QString line);
+
+    // Pending lines joined with '\n' (empty if none); `dropped` receives
+    // the number of lines lost since the previous take().
+    QString take(size_t* dropped = nullptr);
 
 signals:
-    void textReady(const QString& line);
+    // Emitted when the queue goes from empty to non-empty.
+    void pending();
 
-protected:
-    int overflow(int ch) override;
-    int sync() override;
+private:
+    std::mutex mutex_;
+    std::vector<QString> ring_;
+    size_t head_ = 0;   // oldest pending line
+    size_t count_ = 0;
+    size_t dropped_ = 0;
+};
+
+// Logger sink for the GUI log panel; safe to call from any thread.
+class QtLogSink : public logging::Sink
+{
+public:
+    explicit QtLogSink(LogQueue* queue);
+    void write(logging::Level level, std::string_view text) override;
 
 private:
-    QString buffer_;
+    LogQueue* queue_;
 };
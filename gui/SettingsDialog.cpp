@@ -3,6 +3,8 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QCheckBox>
+#include <QLabel>
+#include <QSpinBox>
 #include <QPushButton>
 
 SettingsDialog::SettingsDialog(QWidget* parent)
@@ -22,6 +24,14 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     root->addWidget(snap_);
     root->addWidget(autosave_);
 
+    auto* cacheRow = new QHBoxLayout;
+    imageCache_ = new QSpinBox;
+    imageCache_->setRange(0, 8192);
+    imageCache_->setSuffix(" MB");
+    cacheRow->addWidget(new QLabel("Decoded image cache"));
+    cacheRow->addWidget(imageCache_);
+    root->addLayout(cacheRow);
+
     auto* buttons = new QHBoxLayout;
     auto* ok = new QPushButton("OK");
     auto* cancel = new QPushButton("Cancel");
@@ -39,8 +49,10 @@ void SettingsDialog::setDarkMode(bool on) { dark_->setChecked(on); }
 void SettingsDialog::setShowGrid(bool on) { grid_->setChecked(on); }
 void SettingsDialog::setSnapToGrid(bool on) { snap_->setChecked(on); }
 void SettingsDialog::setAutosaveOnExit(bool on) { autosave_->setChecked(on); }
+void SettingsDialog::setImageCacheMB(int mb) { imageCache_->setValue(mb); }
 
 bool SettingsDialog::darkMode() const { return dark_->isChecked(); }
 bool SettingsDialog::showGrid() const { return grid_->isChecked(); }
 bool SettingsDialog::snapToGrid() const { return snap_->isChecked(); }
 bool SettingsDialog::autosaveOnExit() const { return autosave_->isChecked(); }
+int SettingsDialog::imageCacheMB() const { return imageCache_->value(); }
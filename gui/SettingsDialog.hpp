@@ -3,6 +3,7 @@
 #include <QDialog>
 
 class QCheckBox;
+class QSpinBox;
 
 class SettingsDialog : public QDialog {
     Q_OBJECT
@@ -13,15 +14,18 @@ public:
     void setShowGrid(bool on);
     void setSnapToGrid(bool on);
     void setAutosaveOnExit(bool on);
+    void setImageCacheMB(int mb);
 
     bool darkMode() const;
     bool showGrid() const;
     bool snapToGrid() const;
     bool autosaveOnExit() const;
+    int imageCacheMB() const;
 
 private:
     QCheckBox* dark_ = nullptr;
     QCheckBox* grid_ = nullptr;
     QCheckBox* snap_ = nullptr;
     QCheckBox* autosave_ = nullptr;
+    QSpinBox* imageCache_ = nullptr;
 };
@@ -1,42 +1,352 @@
 #include "gui/SlideList.hpp"
+#include "gui/SlideRenderer.hpp"
 
+#include "Slide.hpp"
+#include "Session.hpp"
+
+#include <QImage>
+#include <QItemSelectionModel>
+#include <QMetaObject>
+#include <QPixmap>
+#include <QScrollBar>
 #include <QSignalBlocker>
+#include <QThread>
 #include <algorithm>
+#include <memory>
 
-SlideList::SlideList(QWidget* parent)
-    : QListWidget(parent)
+namespace {
+
+PixmapCache::Key thumbKey(uint64_t hash, const QSize& size)
 {
-    connect(this, &QListWidget::currentRowChanged, this, [this](int row) {
-        if (row >= 0) emit slideChosen(row);
+    return {hash, 0, 0, 0, 0, 0, size.width(), size.height()};
+}
+
+} // namespace
+
+SlideListModel::SlideListModel(QObject* parent)
+    : QAbstractListModel(parent), thumbs_(size_t(64) << 20)
+{
+    pool_.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+}
+
+SlideListModel::~SlideListModel()
+{
+    // Workers post results to this object; none may be running past here.
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.clear();
+    }
+    pool_.clear();
+    pool_.waitForDone();
+}
+
+int SlideListModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) return 0;
+    if (!slides_) return 1;  // the "no presentation" row
+    return static_cast<int>(hashes_.size());
+}
+
+QVariant SlideListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()) return QVariant();
+    const int row = index.row();
+
+    if (!slides_) {
+        if (role == Qt::DisplayRole) return QString("<<no presentation>>");
+        return QVariant();
+    }
+    if (row < 0 || row >= static_cast<int>(hashes_.size())) return QVariant();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("Slide %1").arg(row + 1);
+    case Qt::DecorationRole: {
+        QPixmap pm = thumbs_.find(thumbKey(hashes_[(size_t)row], thumbSize_));
+        if (pm.isNull()) {
+            requestThumbnail(row);
+            if (blank_.isNull()) {
+                blank_ = QPixmap(thumbSize_);
+                blank_.fill(Qt::white);
+            }
+            pm = blank_;
+        }
+        return pm;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+void SlideListModel::setSlides(const std::vector<::Slide>* slides)
+{
+    if ((slides == nullptr) != (slides_ == nullptr)) {
+        // Switching between "no presentation" and a deck changes what the
+        // rows mean; start over.
+        beginResetModel();
+        slides_ = slides;
+        hashes_.clear();
+        if (slides_) {
+            hashes_.reserve(slides_->size());
+            for (const auto& s : *slides_) hashes_.push_back(render::contentHash(s));
+        }
+        endResetModel();
+        dirty_.clear();
+        stale_ = false;
+        return;
+    }
+    if (!slides) return;
+
+    // Another presentation, or edits that were not reported row by row.
+    if (slides != slides_ || stale_ || hashes_.size() != slides->size()) {
+        slides_ = slides;
+        diffAll();
+    } else {
+        std::sort(dirty_.begin(), dirty_.end());
+        dirty_.erase(std::unique(dirty_.begin(), dirty_.end()), dirty_.end());
+        for (size_t row : dirty_) {
+            const uint64_t h = render::contentHash((*slides_)[row]);
+            if (h == hashes_[row]) continue;
+            hashes_[row] = h;
+            emit dataChanged(index((int)row), index((int)row), {Qt::DecorationRole});
+        }
+    }
+    dirty_.clear();
+    stale_ = false;
+}
+
+void SlideListModel::diffAll()
+{
+    std::vector<uint64_t> next;
+    next.reserve(slides_->size());
+    for (const auto& s : *slides_) next.push_back(render::contentHash(s));
+
+    const int oldCount = static_cast<int>(hashes_.size());
+    const int newCount = static_cast<int>(next.size());
+    const int common = std::min(oldCount, newCount);
+
+    if (newCount < oldCount) {
+        beginRemoveRows(QModelIndex(), newCount, oldCount - 1);
+        hashes_.resize((size_t)newCount);
+        endRemoveRows();
+    } else if (newCount > oldCount) {
+        beginInsertRows(QModelIndex(), oldCount, newCount - 1);
+        hashes_.insert(hashes_.end(), next.begin() + oldCount, next.end());
+        endInsertRows();
+    }
+
+    // Report changed rows as contiguous runs.
+    for (int i = 0; i < common;) {
+        if (hashes_[(size_t)i] == next[(size_t)i]) { ++i; continue; }
+        const int first = i;
+        while (i < common && hashes_[(size_t)i] != next[(size_t)i]) {
+            hashes_[(size_t)i] = next[(size_t)i];
+            ++i;
+        }
+        emit dataChanged(index(first), index(i - 1), {Qt::DecorationRole});
+    }
+}
+
+void SlideListModel::applyEdit(const SlideEdit& edit)
+{
+    if (!slides_ || stale_) return;
+    const size_t n = hashes_.size();
+
+    switch (edit.kind) {
+    case SlideEdit::Kind::Change:
+        if (edit.first < n) {
+            // Re-hashed in setSlides(), once the command is done with it.
+            dirty_.push_back(edit.first);
+            return;
+        }
+        break;
+
+    case SlideEdit::Kind::Insert:
+        if (edit.count > 0 && edit.first <= n && edit.first + edit.count <= slides_->size()) {
+            const int first = (int)edit.first;
+            beginInsertRows(QModelIndex(), first, first + (int)edit.count - 1);
+            std::vector<uint64_t> added;
+            added.reserve(edit.count);
+            for (size_t i = 0; i < edit.count; ++i)
+                added.push_back(render::contentHash((*slides_)[edit.first + i]));
+            hashes_.insert(hashes_.begin() + first, added.begin(), added.end());
+            for (size_t& d : dirty_) if (d >= edit.first) d += edit.count;
+            endInsertRows();
+            return;
+        }
+        break;
+
+    case SlideEdit::Kind::Remove:
+        if (edit.count > 0 && edit.first + edit.count <= n) {
+            const int first = (int)edit.first;
+            beginRemoveRows(QModelIndex(), first, first + (int)edit.count - 1);
+            hashes_.erase(hashes_.begin() + first, hashes_.begin() + first + (int)edit.count);
+            std::vector<size_t> kept;
+            for (size_t d : dirty_) {
+                if (d < edit.first) kept.push_back(d);
+                else if (d >= edit.first + edit.count) kept.push_back(d - edit.count);
+            }
+            dirty_ = std::move(kept);
+            endRemoveRows();
+            return;
+        }
+        break;
+
+    case SlideEdit::Kind::Move: {
+        const size_t from = edit.first, to = edit.count;
+        if (from < n && to < n) {
+            if (from == to) return;
+            // Qt wants the destination as the row the item goes before.
+            const int dest = (int)(to > from ? to + 1 : to);
+            if (beginMoveRows(QModelIndex(), (int)from, (int)from, QModelIndex(), dest)) {
+                if (from < to)
+                    std::rotate(hashes_.begin() + from, hashes_.begin() + from + 1, hashes_.begin() + to + 1);
+                else
+                    std::rotate(hashes_.begin() + to, hashes_.begin() + from, hashes_.begin() + from + 1);
+                for (size_t& d : dirty_) {
+                    if (d == from) d = to;
+                    else if (from < to && d > from && d <= to) --d;
+                    else if (from > to && d >= to && d < from) ++d;
+                }
+                endMoveRows();
+                return;
+            }
+        }
+        break;
+    }
+
+    case SlideEdit::Kind::Reset:
+        break;
+    }
+
+    // Not something we can follow row by row; compare everything next sync.
+    stale_ = true;
+}
+
+void SlideListModel::keepOnlyRows(int first, int last)
+{
+    if (!slides_) return;
+    first = std::max(first, 0);
+    last = std::min(last, static_cast<int>(hashes_.size()) - 1);
+
+    std::unordered_set<uint64_t> visible;
+    for (int i = first; i <= last; ++i) visible.insert(hashes_[(size_t)i]);
+
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (visible.count(*it)) ++it;
+        else it = pending_.erase(it);
+    }
+}
+
+void SlideListModel::requestThumbnail(int row) const
+{
+    const uint64_t hash = hashes_[(size_t)row];
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (!pending_.insert(hash).second) return;
+    }
+
+    // The worker draws from its own copy; the session may change meanwhile.
+    // Image bytes are shared, so this copies shape fields, not pixels.
+    auto slide = std::make_shared<const ::Slide>((*slides_)[(size_t)row]);
+    auto* self = const_cast<SlideListModel*>(this);
+    const QSize size = thumbSize_;
+
+    pool_.start([self, hash, slide, size]() {
+        {
+            std::lock_guard<std::mutex> lock(self->pendingMutex_);
+            if (!self->pending_.count(hash)) return;  // scrolled away
+        }
+        QImage img = render::slideImage(*slide, size);
+        QMetaObject::invokeMethod(self, [self, hash, img = std::move(img)]() {
+            self->thumbnailReady(hash, img);
+        }, Qt::QueuedConnection);
     });
 }
 
+void SlideListModel::thumbnailReady(uint64_t hash, const QImage& img)
+{
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.erase(hash);
+    }
+    // Drop thumbnails of content no row shows any more.
+    if (std::find(hashes_.begin(), hashes_.end(), hash) == hashes_.end()) return;
+
+    thumbs_.insert(thumbKey(hash, img.size()), QPixmap::fromImage(img));
+    for (int i = 0; i < static_cast<int>(hashes_.size()); ++i) {
+        if (hashes_[(size_t)i] == hash) emit dataChanged(index(i), index(i), {Qt::DecorationRole});
+    }
+}
+
+SlideList::SlideList(QWidget* parent)
+    : QListView(parent), model_(new SlideListModel(this))
+{
+    setModel(model_);
+    setIconSize(model_->thumbnailSize());
+    // Every row has the same size, so the view never measures all of them.
+    setUniformItemSizes(true);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+
+    connect(selectionModel(), &QItemSelectionModel::currentRowChanged, this,
+            [this](const QModelIndex& current, const QModelIndex&) {
+                if (current.isValid() && hasSlides_) emit slideChosen(current.row());
+            });
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() { trimPending(); });
+}
+
 void SlideList::showNoPresentation()
 {
     // Block signals to avoid triggering MainWindow::onSlideChosen while we
     // are updating the list programmatically.
-    QSignalBlocker blocker(this);
-    clear();
-    addItem("<<no presentation>>");
-    setCurrentRow(0);
+    QSignalBlocker blocker(selectionModel());
+    hasSlides_ = false;
+    model_->setSlides(nullptr);
+    setCurrentIndex(model_->index(0));
 }
 
-void SlideList::setSlideCount(int count, int current)
+void SlideList::setSlides(const std::vector<::Slide>& slides, int current)
 {
-    // IMPORTANT: SlideList emits currentRowChanged when we call setCurrentRow
-    // (and sometimes during clear/addItem). MainWindow listens to this signal
-    // to run a "goto <n>" command.
+    // IMPORTANT: the selection model emits currentRowChanged when we call
+    // setCurrentIndex (and sometimes when rows are inserted or removed).
+    // MainWindow listens to slideChosen to run a "goto <n>" command.
     //
     // When MainWindow syncs the UI from the model, it calls this function.
     // If we don't block signals, we create an infinite recursion:
-    //   syncUiFromModel() -> setSlideCount() -> currentRowChanged -> onSlideChosen()
+    //   syncUiFromModel() -> setSlides() -> currentRowChanged -> onSlideChosen()
     //   -> goto -> syncUiFromModel() -> ... (stack overflow / crash)
-    QSignalBlocker blocker(this);
-    clear();
-    for (int i = 0; i < count; ++i) {
-        addItem(QString("Slide %1").arg(i + 1));
-    }
+    QSignalBlocker blocker(selectionModel());
+    hasSlides_ = true;
+    model_->setSlides(&slides);
+
+    const int count = static_cast<int>(slides.size());
     if (count > 0) {
-        setCurrentRow(std::max(0, std::min(current, count - 1)));
+        const int row = std::max(0, std::min(current, count - 1));
+        setCurrentIndex(model_->index(row));
+        scrollTo(model_->index(row));
     }
+    trimPending();
+}
+
+void SlideList::applyEdit(const SlideEdit& edit)
+{
+    // Row changes move the current index; that is not a user choice.
+    QSignalBlocker blocker(selectionModel());
+    model_->applyEdit(edit);
+}
+
+void SlideList::resizeEvent(QResizeEvent* e)
+{
+    QListView::resizeEvent(e);
+    trimPending();
+}
+
+void SlideList::trimPending()
+{
+    const QModelIndex top = indexAt(viewport()->rect().topLeft());
+    const QModelIndex bottom = indexAt(viewport()->rect().bottomLeft());
+    const int first = top.isValid() ? top.row() : 0;
+    const int last = bottom.isValid() ? bottom.row() : model_->rowCount() - 1;
+    model_->keepOnlyRows(first, last);
 }
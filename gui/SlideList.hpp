@@ -1,15 +1,85 @@
 #pragma once
 
-#include <QListWidget>
+#include "gui/PixmapCache.hpp"
 
-class SlideList : public QListWidget {
+#include <QAbstractListModel>
+#include <QListView>
+#include <QSize>
+#include <QThreadPool>
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+class QImage;
+class Slide;
+struct SlideEdit;
+
+// One row per slide of the current presentation. Thumbnails are rendered
+// on a worker pool only for rows the view asks for, and cached by the
+// slide's content hash, so unchanged slides are never drawn again.
+class SlideListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit SlideListModel(QObject* parent = nullptr);
+    ~SlideListModel() override;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    // `slides` belongs to the session and must stay valid until the next
+    // call; nullptr means no presentation. After edits reported through
+    // applyEdit() only the edited rows are re-hashed; otherwise all rows
+    // are compared and only those whose content changed are reported.
+    void setSlides(const std::vector<::Slide>* slides);
+
+    // Moves, inserts or removes rows for a slide edit as it happens.
+    void applyEdit(const SlideEdit& edit);
+
+    // Forgets queued thumbnails outside [first, last], e.g. after scrolling.
+    void keepOnlyRows(int first, int last);
+
+    QSize thumbnailSize() const { return thumbSize_; }
+
+private:
+    void diffAll();
+    void requestThumbnail(int row) const;
+    void thumbnailReady(uint64_t hash, const QImage& img);
+
+    const std::vector<::Slide>* slides_ = nullptr;
+    std::vector<uint64_t> hashes_;  // render::contentHash() per row
+    QSize thumbSize_{160, 90};
+    std::vector<size_t> dirty_;     // rows changed since setSlides()
+    bool stale_ = false;            // an edit was not reported precisely
+
+    mutable PixmapCache thumbs_;    // keyed by content hash
+    mutable QPixmap blank_;         // shown while a thumbnail renders
+    mutable QThreadPool pool_;
+    // Hashes queued or rendering; a worker skips a hash removed from here.
+    mutable std::mutex pendingMutex_;
+    mutable std::unordered_set<uint64_t> pending_;
+};
+
+class SlideList : public QListView {
     Q_OBJECT
 public:
     explicit SlideList(QWidget* parent = nullptr);
 
     void showNoPresentation();
-    void setSlideCount(int count, int current);
+    void setSlides(const std::vector<::Slide>& slides, int current);
+    void applyEdit(const SlideEdit& edit);
 
 signals:
     void slideChosen(int index);
+
+protected:
+    void resizeEvent(QResizeEvent* e) override;
+
+private:
+    void trimPending();
+
+    SlideListModel* model_ = nullptr;
+    bool hasSlides_ = false;
 };
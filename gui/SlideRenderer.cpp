@@ -0,0 +1,172 @@
+#include "gui/SlideRenderer.hpp"
+
+#include "Slide.hpp"
+#include "Shape.hpp"
+
+#include <QPainter>
+#include <QPen>
+#include <QBrush>
+#include <QFont>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+inline void mix(uint64_t& h, uint64_t v)
+{
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+}
+
+// QGraphicsTextItem's default document margin, so text lands where the
+// canvas puts it.
+constexpr int kTextMargin = 4;
+
+void drawText(QPainter& p, const QPointF& at, const std::string& text, int pointSize)
+{
+    if (text.empty()) return;
+    QFont f = p.font();
+    f.setPointSize(pointSize);
+    p.setFont(f);
+    p.setPen(Qt::black);
+    p.drawText(QRectF(at.x() + kTextMargin, at.y() + kTextMargin, render::kSlideW, render::kSlideH),
+               Qt::AlignLeft | Qt::AlignTop, QString::fromStdString(text));
+}
+
+} // namespace
+
+namespace render {
+
+PixmapCache::Key imageKey(const ::Shape& sh)
+{
+    return {sh.getImageHash(), sh.getImageData().size(),
+            sh.getCropL(), sh.getCropT(), sh.getCropR(), sh.getCropB(),
+            sh.getW(), sh.getH()};
+}
+
+QSize fitToSlide(int w, int h)
+{
+    if (w <= 0) w = 1;
+    if (h <= 0) h = 1;
+
+    if (w > kSlideW || h > kSlideH) {
+        double sx = (double)kSlideW / (double)w;
+        double sy = (double)kSlideH / (double)h;
+        double s = std::min(sx, sy);
+        w = std::max(1, (int)std::round(w * s));
+        h = std::max(1, (int)std::round(h * s));
+    }
+    return QSize(w, h);
+}
+
+QImage decodeImage(const QByteArray& bytes, const PixmapCache::Key& key, double scale)
+{
+    QImage img = QImage::fromData(bytes);
+    if (img.isNull()) return QImage();
+
+    // Apply PPTX-style crop (a:srcRect). Values are 0..100000 (1/1000 of a percent).
+    const int cl = key.cropL;
+    const int ct = key.cropT;
+    const int cr = key.cropR;
+    const int cb = key.cropB;
+    if ((cl | ct | cr | cb) != 0) {
+        const int W = img.width();
+        const int H = img.height();
+
+        int x0 = (int)std::round((double)cl * (double)W / 100000.0);
+        int y0 = (int)std::round((double)ct * (double)H / 100000.0);
+        int x1 = W - (int)std::round((double)cr * (double)W / 100000.0);
+        int y1 = H - (int)std::round((double)cb * (double)H / 100000.0);
+
+        x0 = std::clamp(x0, 0, W);
+        y0 = std::clamp(y0, 0, H);
+        x1 = std::clamp(x1, 0, W);
+        y1 = std::clamp(y1, 0, H);
+
+        int cw = std::max(1, x1 - x0);
+        int ch = std::max(1, y1 - y0);
+        img = img.copy(x0, y0, cw, ch);
+    }
+
+    QSize target = fitToSlide(key.width > 1 ? key.width : img.width(),
+                              key.height > 1 ? key.height : img.height());
+    if (scale != 1.0) {
+        target = QSize(std::max(1, (int)std::round(target.width() * scale)),
+                       std::max(1, (int)std::round(target.height() * scale)));
+    }
+
+    // Scale before the image is uploaded, so only the final size is converted.
+    if (img.size() != target) {
+        img = img.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    return img;
+}
+
+uint64_t contentHash(const ::Slide& slide)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (const ::Shape& sh : slide.getShapes()) {
+        mix(h, static_cast<uint64_t>(sh.kind()));
+        mix(h, (uint64_t(uint32_t(sh.getX())) << 32) | uint32_t(sh.getY()));
+        mix(h, (uint64_t(uint32_t(sh.getW())) << 32) | uint32_t(sh.getH()));
+        mix(h, std::hash<std::string>{}(sh.getText()));
+        if (sh.isImage()) {
+            mix(h, sh.getImageHash());
+            mix(h, sh.getImageData().size());
+            mix(h, (uint64_t(uint32_t(sh.getCropL())) << 32) | uint32_t(sh.getCropT()));
+            mix(h, (uint64_t(uint32_t(sh.getCropR())) << 32) | uint32_t(sh.getCropB()));
+        }
+    }
+    mix(h, slide.getShapes().size());
+    return h;
+}
+
+QImage slideImage(const ::Slide& slide, const QSize& size)
+{
+    QImage img(size, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::white);
+
+    QPainter p(&img);
+    p.setRenderHint(QPainter::Antialiasing, true);
+    p.setRenderHint(QPainter::TextAntialiasing, true);
+    p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    // Draw in slide coordinates, like the canvas scene.
+    const double sx = double(size.width()) / kSlideW;
+    const double sy = double(size.height()) / kSlideH;
+    p.scale(sx, sy);
+
+    for (const ::Shape& sh : slide.getShapes()) {
+        const QPointF at(sh.getX(), sh.getY());
+
+        if (sh.isImage()) {
+            const auto& data = sh.getImageData();
+            const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data.data()),
+                                                             static_cast<qsizetype>(data.size()));
+            // Decode at output resolution rather than scaling slide-sized pixels.
+            const double scale = std::min(sx, sy);
+            const QImage pic = decodeImage(bytes, imageKey(sh), scale);
+            if (!pic.isNull()) p.drawImage(QRectF(at, QSizeF(pic.size()) / scale), pic);
+            continue;
+        }
+
+        if (sh.kind() == ShapeKind::Rect || sh.kind() == ShapeKind::Ellipse) {
+            const QRectF r(at, QSizeF(std::max(1, sh.getW()), std::max(1, sh.getH())));
+            p.setPen(QPen(Qt::black));
+            p.setBrush(QBrush(QColor(230, 230, 230)));
+            if (sh.kind() == ShapeKind::Rect) p.drawRect(r);
+            else p.drawEllipse(r);
+            drawText(p, at + QPointF(10, 8), sh.getText(), 14);
+            continue;
+        }
+
+        drawText(p, at, sh.getText(), 16);
+    }
+
+    p.resetTransform();
+    p.setPen(QPen(QColor(160, 160, 160)));
+    p.setBrush(Qt::NoBrush);
+    p.drawRect(0, 0, size.width() - 1, size.height() - 1);
+    return img;
+}
+
+} // namespace render
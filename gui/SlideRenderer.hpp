@@ -0,0 +1,39 @@
+#pragma once
+
+#include "gui/PixmapCache.hpp"
+
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+
+#include <cstdint>
+
+class Slide;
+class Shape;
+
+// Slide drawing shared by the canvas and the slide thumbnails. Everything
+// here works on QImage and may run on worker threads.
+namespace render {
+
+constexpr int kSlideW = 960;
+constexpr int kSlideH = 540;
+
+// Cache key of an image shape's decoded pixels.
+PixmapCache::Key imageKey(const ::Shape& sh);
+
+// Size an image of w x h gets on the slide: shrunk to fit if larger.
+QSize fitToSlide(int w, int h);
+
+// Decodes, crops and scales encoded image bytes as described by `key`
+// (crop and target size on the slide), times `scale` for output that is
+// not at slide resolution. Null on failure.
+QImage decodeImage(const QByteArray& bytes, const PixmapCache::Key& key, double scale = 1.0);
+
+// Hash of everything that affects how a slide looks; equal hashes draw
+// identical thumbnails.
+uint64_t contentHash(const ::Slide& slide);
+
+// The whole slide drawn at `size` (thumbnails, full-screen playback).
+QImage slideImage(const ::Slide& slide, const QSize& size);
+
+} // namespace render
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocation counting for benchmarks and allocation budgets. When the
+// build defines SLIDESHOW_ALLOC_COUNTING (CMake option of the same name)
+// the global operator new/delete are replaced by counting versions; each
+// thread keeps its own totals, so a Scope only sees its own thread's
+// allocations. Without the option everything here reports zero.
+namespace alloc {
+
+struct Counts
+{
+    uint64_t allocs = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;  // requested by allocations
+};
+
+// True when the counting hooks are compiled in.
+bool enabled();
+
+// Totals for the calling thread since it started.
+Counts threadCounts();
+
+// Allocations made by the calling thread since construction.
+class Scope
+{
+public:
+    Scope() : start_(threadCounts()) {}
+
+    Counts counts() const
+    {
+        const Counts now = threadCounts();
+        return {now.allocs - start_.allocs, now.frees - start_.frees, now.bytes - start_.bytes};
+    }
+
+private:
+    Counts start_;
+};
+
+} // namespace alloc
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ICommand.hpp"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+// An I/O-bound operation running on a worker thread.
+//
+// `work` runs on the worker: it must not touch the Controller or print, and
+// should poll cancelFlag() / call setProgress(), and returns how it ended:
+// a cancel request that came too late does not make finished work
+// Cancelled. `finish` runs on whichever thread calls complete() (the model
+// thread: CLI loop or Qt event loop) and applies the result and reports it.
+class AsyncTask
+{
+public:
+    enum class Result { Done, Failed, Cancelled };
+
+    using Work = std::function<Result(AsyncTask&)>;
+    using Finish = std::function<void(bool ok, bool cancelled)>;
+
+    AsyncTask(std::string label, Work work, Finish finish);
+    ~AsyncTask();
+
+    AsyncTask(const AsyncTask&) = delete;
+    AsyncTask& operator=(const AsyncTask&) = delete;
+
+    void start();
+    bool isReady() const;
+    void wait() const;
+
+    // Runs `finish` once; waits for the worker first if needed.
+    void complete();
+    bool isCompleted() const;
+
+    void cancel();
+    bool isCancelled() const;
+    const std::atomic<bool>& cancelFlag() const;
+
+    void setProgress(double fraction);
+    int progressPercent() const;
+
+    const std::string& label() const;
+
+private:
+    std::string label_;
+    Work work_;
+    Finish finish_;
+    std::future<Result> result_;
+    std::atomic<bool> cancel_{false};
+    std::atomic<int> progress_{0};
+    bool completed_ = false;
+};
+
+// A command whose I/O can run off the model thread. execute() keeps the
+// old synchronous behaviour; callers that can keep their event loop going
+// use startAsync() and call complete() on the returned task later.
+class IAsyncCommand : public ICommand
+{
+public:
+    // Validates arguments and launches the worker. Returns nullptr (after
+    // reporting the problem) if there is nothing to run.
+    virtual std::shared_ptr<AsyncTask> startAsync() = 0;
+
+    // True if the model may keep changing while the task runs (the task
+    // works on its own copy), so the CLI can return to the prompt at once.
+    virtual bool allowsEditingWhileRunning() const { return false; }
+
+    void execute() override;
+};
@@ -1,5 +1,4 @@
 #pragma once
-#include <iostream>
 #include <cstdlib>
 
 #if defined(_WIN32)
@@ -12,10 +11,11 @@
     #define FILENO fileno
 #endif
 
+// Probed once; the environment and stdout do not change while running.
 inline bool colorEnabled()
 {
-    if (std::getenv("SLIDESHOW_NO_COLOR")) return false;
-    return ISATTY(FILENO(stdout)) != 0;
+    static const bool enabled = !std::getenv("SLIDESHOW_NO_COLOR") && ISATTY(FILENO(stdout)) != 0;
+    return enabled;
 }
 
 struct ColorCode
@@ -31,21 +31,3 @@ inline const ColorCode YELLOW  { "\033[33m" };
 inline const ColorCode BLUE    { "\033[34m" };
 inline const ColorCode MAGENTA { "\033[35m" };
 inline const ColorCode CYAN    { "\033[36m" };
-
-inline std::ostream& info()
-{
-    if (colorEnabled()) return std::cout << GREEN << "[INFO] " << RESET;
-    return std::cout << "[INFO] ";
-}
-
-inline std::ostream& error()
-{
-    if (colorEnabled()) return std::cout << RED << "[ERR] " << RESET;
-    return std::cout << "[ERR] ";
-}
-
-inline std::ostream& success()
-{
-    if (colorEnabled()) return std::cout << CYAN << "[SUCCESS] " << RESET;
-    return std::cout << "[SUCCESS] ";
-}
@@ -3,8 +3,14 @@
 #include <memory>
 
 class ICommand;
+class Session;
 
 class CommandParser {
 public:
+    // Parses one line into a command bound to the default session
+    // (Controller::instance()).
     static std::unique_ptr<ICommand> parse(std::istream& in);
+
+    // Same, with the command bound to `session`.
+    static std::unique_ptr<ICommand> parse(std::istream& in, Session& session);
 };
@@ -1,11 +1,16 @@
 #pragma once
 #include "ICommand.hpp"
-#include "Controller.hpp"
+#include "AsyncTask.hpp"
+#include "Session.hpp"
 
 #include <string>
 #include <vector>
 #include <memory>
 
+// True for commands that change the document, so the caller records an
+// undo snapshot before executing them (CLI loop and RPC server policy).
+bool isUndoableCommand(const ICommand* cmd);
+
 // -------------------------
 // Basic commands
 // -------------------------
@@ -20,121 +25,135 @@ public:
 };
 
 class CommandCreateSlideshow : public ICommand {
-    Controller& ctrl;
+    Session& session;
     std::vector<std::string> nameTokens;
 public:
-    CommandCreateSlideshow(Controller& c, const std::vector<std::string>& name);
+    CommandCreateSlideshow(Session& c, const std::vector<std::string>& name);
     void execute() override;
 };
 
-class CommandOpen : public ICommand {
-    Controller& ctrl;
+// Open and save do their file I/O through startAsync(); execute() still
+// runs them to completion on the calling thread.
+class CommandOpen : public IAsyncCommand {
+    Session& session;
     std::vector<std::string> args;
 public:
-    CommandOpen(Controller& c, const std::vector<std::string>& a);
-    void execute() override;
+    CommandOpen(Session& c, const std::vector<std::string>& a);
+    std::shared_ptr<AsyncTask> startAsync() override;
 };
 
-class CommandSave : public ICommand {
+class CommandSave : public IAsyncCommand {
+    Session& session;
     std::string file;
 public:
-    CommandSave(const std::string& f);
+    CommandSave(Session& s, const std::string& f);
     void execute() override;
+    std::shared_ptr<AsyncTask> startAsync() override;
+    bool allowsEditingWhileRunning() const override { return true; }
 };
 
 class CommandAutoSave : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    bool query = false;  // no argument: report the setting
+    bool on = false;
+    std::string argError;
 public:
-    CommandAutoSave(Controller& c, const std::vector<std::string>& a);
+    CommandAutoSave(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandNextFile : public ICommand {
-    Controller& ctrl;
+    Session& session;
 public:
-    CommandNextFile(Controller& c);
+    CommandNextFile(Session& c);
     void execute() override;
 };
 
 class CommandPrevFile : public ICommand {
-    Controller& ctrl;
+    Session& session;
 public:
-    CommandPrevFile(Controller& c);
+    CommandPrevFile(Session& c);
     void execute() override;
 };
 
 class CommandAddSlide : public ICommand {
-    Controller& ctrl;
+    Session& session;
     std::vector<std::string> args;
 public:
-    CommandAddSlide(Controller& c, const std::vector<std::string>& a);
+    CommandAddSlide(Session& c, const std::vector<std::string>& a);
     void execute() override;
 };
 
 class CommandRemoveSlide : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    int idx = 0;
+    std::string argError;
 public:
-    CommandRemoveSlide(Controller& c, const std::vector<std::string>& a);
+    CommandRemoveSlide(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandMoveSlide : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    int from = 0, to = 0;
+    std::string argError;
 public:
-    CommandMoveSlide(Controller& c, const std::vector<std::string>& a);
+    CommandMoveSlide(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandGotoSlide : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    int idx = 0;
+    std::string argError;
 public:
-    CommandGotoSlide(Controller& c, const std::vector<std::string>& a);
+    CommandGotoSlide(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandNext : public ICommand {
-    class SlideShow& ss;
+    Session& session;
 public:
-    CommandNext(class SlideShow& s);
+    CommandNext(Session& c);
     void execute() override;
 };
 
 class CommandPrev : public ICommand {
-    class SlideShow& ss;
+    Session& session;
 public:
-    CommandPrev(class SlideShow& s);
+    CommandPrev(Session& c);
     void execute() override;
 };
 
 class CommandShow : public ICommand {
-    class SlideShow& ss;
+    Session& session;
 public:
-    CommandShow(class SlideShow& s);
+    CommandShow(Session& c);
     void execute() override;
 };
 
 class CommandPreview : public ICommand {
-    Controller& ctrl;
+    Session& session;
 public:
-    CommandPreview(Controller& c);
+    CommandPreview(Session& c);
     void execute() override;
 };
 
 class CommandUndo : public ICommand {
-    Controller& ctrl;
+    Session& session;
 public:
-    CommandUndo(Controller& c);
+    CommandUndo(Session& c);
     void execute() override;
 };
 
 class CommandRedo : public ICommand {
-    Controller& ctrl;
+    Session& session;
 public:
-    CommandRedo(Controller& c);
+    CommandRedo(Session& c);
     void execute() override;
 };
 
@@ -144,56 +163,150 @@ public:
 // These fix your linker errors (vtable/typeinfo) because execute() is defined in Commands.cpp
 
 class CommandListShapes : public ICommand {
-    Controller& ctrl;
+    Session& session;
 public:
-    CommandListShapes(Controller& c);
+    CommandListShapes(Session& c);
     void execute() override;
 };
 
 class CommandAddShape : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    ShapeKind kind = ShapeKind::Rect;
+    int x = 0, y = 0, w = 1, h = 1;
+    std::string text;
+    std::string path;  // image
+    std::string argError;
 public:
-    CommandAddShape(Controller& c, const std::vector<std::string>& a);
+    CommandAddShape(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandRemoveShape : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    int idx = 0;
+    std::string argError;
 public:
-    CommandRemoveShape(Controller& c, const std::vector<std::string>& a);
+    CommandRemoveShape(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandMoveShape : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    int idx = 0, x = 0, y = 0;
+    std::string argError;
 public:
-    CommandMoveShape(Controller& c, const std::vector<std::string>& a);
+    CommandMoveShape(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandResizeShape : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    int idx = 0, w = 1, h = 1;
+    std::string argError;
 public:
-    CommandResizeShape(Controller& c, const std::vector<std::string>& a);
+    CommandResizeShape(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandSetShapeText : public ICommand {
-    Controller& ctrl;
-    std::vector<std::string> args;
+    Session& session;
+    int idx = 0;
+    std::string text;
+    std::string argError;
 public:
-    CommandSetShapeText(Controller& c, const std::vector<std::string>& a);
+    CommandSetShapeText(Session& c, const std::vector<std::string>& a);
     void execute() override;
+    std::string argumentError() const override { return argError; }
 };
 
 class CommandDuplicateShape : public ICommand {
-    Controller& ctrl;
+    Session& session;
+    int idx = 0, dx = 20, dy = 20;
+    std::string argError;
+public:
+    CommandDuplicateShape(Session& c, const std::vector<std::string>& a);
+    void execute() override;
+    std::string argumentError() const override { return argError; }
+};
+
+// -------------------------
+// Macros
+// -------------------------
+// Lines parsed while recording are compiled once on "stop" into ready-to-run
+// ICommand objects with their arguments already parsed; "play" executes
+// those directly, skipping the tokenizer. A step whose arguments do not
+// parse discards the macro.
+
+class CommandRecordMacro : public ICommand {
+    Session& session;
+    std::vector<std::string> args;
+public:
+    CommandRecordMacro(Session& c, const std::vector<std::string>& a);
+    void execute() override;
+};
+
+class CommandStopRecording : public ICommand {
+    Session& session;
+public:
+    CommandStopRecording(Session& c);
+    void execute() override;
+};
+
+class CommandPlayMacro : public ICommand {
+    Session& session;
+    std::vector<std::string> args;
+public:
+    CommandPlayMacro(Session& c, const std::vector<std::string>& a);
+    void execute() override;
+};
+
+class CommandFindShapes : public ICommand {
+    Session& session;
+    enum class Scope { Slide, Slides, Presentations } scope = Scope::Slide;
+    std::string needle;
+    std::string argError;
+public:
+    CommandFindShapes(Session& c, const std::vector<std::string>& a);
+    void execute() override;
+    std::string argumentError() const override { return argError; }
+};
+
+// stats [reset]: per-phase timing histograms (see Profiler.hpp).
+class CommandStats : public ICommand {
+    std::vector<std::string> args;
+public:
+    CommandStats(const std::vector<std::string>& a);
+    void execute() override;
+};
+
+// trace start <file.json> | trace stop: Chrome trace of all timed phases.
+class CommandTrace : public ICommand {
+    std::vector<std::string> args;
+public:
+    CommandTrace(const std::vector<std::string>& a);
+    void execute() override;
+};
+
+// mem [top=N]: estimated memory per presentation, largest slides, image
+// payloads (unique vs. duplicated) and undo/redo history (see MemoryStats.hpp).
+class CommandMem : public ICommand {
+    Session& session;
+    std::vector<std::string> args;
+public:
+    CommandMem(Session& c, const std::vector<std::string>& a);
+    void execute() override;
+};
+
+// generate deck <slides> <shapes> [images=N dup=P seed=S words=W imgsize=PX name=NAME]
+// Adds a synthetic presentation built by generateDeck() and makes it current.
+class CommandGenerateDeck : public ICommand {
+    Session& session;
     std::vector<std::string> args;
 public:
-    CommandDuplicateShape(Controller& c, const std::vector<std::string>& a);
+    CommandGenerateDeck(Session& c, const std::vector<std::string>& a);
     void execute() override;
 };
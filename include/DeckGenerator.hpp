@@ -0,0 +1,23 @@
+#pragma once
+
+#include "SlideShow.hpp"
+
+#include <cstdint>
+#include <string>
+
+// Parameters for a synthetic deck. The same spec and seed always produce the
+// same deck (shape ids aside), so benchmarks and stress runs are repeatable.
+struct DeckSpec
+{
+    std::string name = "Generated";
+    size_t slides = 10;
+    size_t shapesPerSlide = 5;  // rect/ellipse/text mix
+    size_t maxWords = 12;       // text length: 1..maxWords words per shape
+    size_t images = 0;          // spread round-robin over the slides
+    unsigned imageSize = 64;    // square, in pixels
+    double duplicateRatio = 0;  // 0..1: share of images that reuse earlier bytes
+    uint32_t seed = 1;
+};
+
+// Builds the deck directly (no file I/O, no command parsing).
+SlideShow generateDeck(const DeckSpec& spec);
@@ -1,7 +1,15 @@
 #pragma once
 
+#include <string>
+
 class ICommand {
 public:
     virtual ~ICommand();
     virtual void execute() = 0;
-};
\ No newline at end of file
+
+    // Slide and shape commands parse their arguments once, in the
+    // constructor, so a macro replays them without re-parsing. Empty if the
+    // arguments parsed; otherwise the message execute() reports instead of
+    // running. Commands that keep their raw arguments return empty.
+    virtual std::string argumentError() const { return {}; }
+};
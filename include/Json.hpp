@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Minimal JSON support for the machine-facing interfaces (RPC server,
+// structured output). Values are parsed into a small tree; writing is done
+// by appending to a std::string.
+namespace json {
+
+struct Value
+{
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Value> array;
+    std::vector<std::pair<std::string, Value>> object; // in document order
+
+    bool isNull() const { return type == Type::Null; }
+    bool isString() const { return type == Type::String; }
+    bool isNumber() const { return type == Type::Number; }
+    bool isArray() const { return type == Type::Array; }
+    bool isObject() const { return type == Type::Object; }
+
+    // Object member lookup; returns nullptr if absent or not an object.
+    const Value* find(const std::string& key) const;
+};
+
+// Parses one complete JSON document. On failure returns false and sets
+// `err` (if given) to a short description.
+bool parse(std::string_view text, Value& out, std::string* err = nullptr);
+
+// Appends `s` as a quoted, escaped JSON string.
+void appendString(std::string& out, std::string_view s);
+
+// Appends the value as compact JSON.
+void append(std::string& out, const Value& v);
+
+} // namespace json
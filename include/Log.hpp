@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Command output and diagnostics. info(), success(), error() and out()
+// return a LogLine; whatever is streamed into it becomes one record when the
+// temporary dies at the end of the statement, and that record is handed to
+// every installed sink. Records below the minimum level are dropped before
+// any formatting happens.
+namespace logging {
+
+// Output is plain command output (listings, help) and is never filtered.
+enum class Level { Info, Success, Error, Output };
+
+// "[INFO] ", "[SUCCESS] ", "[ERR] ", or "" for Output.
+const char* tag(Level level);
+
+// "info", "success", "error" or "quiet" (command output only).
+bool parseLevel(const std::string& name, Level& out);
+
+class Sink
+{
+public:
+    virtual ~Sink() = default;
+    // `text` is the record as streamed: usually one line with its '\n',
+    // sometimes several lines.
+    virtual void write(Level level, std::string_view text) = 0;
+    virtual void flush() {}
+};
+
+// Writes to std::cout (through its current rdbuf, so output captures keep
+// working), with coloured tags on a terminal. Installed by default.
+std::shared_ptr<Sink> consoleSink();
+
+// Appends to `path` through a 64 KB buffer, flushed on errors and flush().
+std::shared_ptr<Sink> fileSink(const std::string& path, std::string* err = nullptr);
+
+// Async sinks are fed from a background thread, so slow sinks (files,
+// widgets) never block the caller; their output is ordered among itself
+// but not against synchronous sinks.
+void addSink(std::shared_ptr<Sink> sink, bool async = false);
+void removeSink(const std::shared_ptr<Sink>& sink);
+
+// Defaults to SLIDESHOW_LOG_LEVEL from the environment, else Info.
+void setMinLevel(Level level);
+Level minLevel();
+bool enabled(Level level);
+
+// Waits for async sinks to catch up, then flushes every sink.
+void flush();
+
+// Error records started on the calling thread so far, including those the
+// minimum level drops. Callers compare two readings to tell whether a
+// command failed.
+size_t errorCount();
+
+class LogLine
+{
+public:
+    explicit LogLine(Level level);
+    ~LogLine();
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    template <class T>
+    LogLine& operator<<(const T& value)
+    {
+        if (os_) *os_ << value;
+        return *this;
+    }
+
+    LogLine& operator<<(std::ostream& (*manip)(std::ostream&))
+    {
+        if (os_) manip(*os_);
+        return *this;
+    }
+
+    // For code that writes to a std::ostream (prof::report).
+    std::ostream& stream();
+
+private:
+    Level level_;
+    std::ostream* os_;  // null when the level is filtered out
+};
+
+} // namespace logging
+
+inline logging::LogLine info() { return logging::LogLine(logging::Level::Info); }
+inline logging::LogLine success() { return logging::LogLine(logging::Level::Success); }
+inline logging::LogLine error() { return logging::LogLine(logging::Level::Error); }
+inline logging::LogLine out() { return logging::LogLine(logging::Level::Output); }
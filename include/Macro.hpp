@@ -0,0 +1,16 @@
+#pragma once
+
+#include "ICommand.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// A recorded command sequence. `source` keeps the original lines for
+// display; `steps` holds the same lines already parsed and bound, so replay
+// goes straight to ICommand::execute().
+struct Macro
+{
+    std::vector<std::string> source;
+    std::vector<std::unique_ptr<ICommand>> steps;
+};
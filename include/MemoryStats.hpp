@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Session;
+class SlideShow;
+class Slide;
+class Shape;
+
+// Estimated memory held by the document model: object sizes plus heap
+// buffers (vector capacity, non-inline string storage). Allocator overhead
+// is not included.
+namespace mem {
+
+size_t bytesOf(const Shape& sh);
+size_t bytesOf(const Slide& slide);
+size_t bytesOf(const SlideShow& ss);
+
+struct PresentationUsage
+{
+    std::string name;
+    size_t slides = 0;
+    size_t shapes = 0;
+    size_t bytes = 0;
+    size_t imageBytes = 0;
+    size_t stringBytes = 0;
+};
+
+struct SlideUsage
+{
+    size_t presentation = 0;  // 0-based
+    size_t slide = 0;         // 0-based
+    size_t bytes = 0;
+};
+
+struct Report
+{
+    std::vector<PresentationUsage> presentations;
+    std::vector<SlideUsage> largestSlides;  // descending
+
+    // Open documents only. Image buffers shared between shapes (copies of
+    // one shape) are counted once.
+    size_t totalBytes = 0;
+    size_t images = 0;
+    size_t imageBytes = 0;
+    size_t uniqueImages = 0;
+    size_t uniqueImageBytes = 0;  // duplicated = imageBytes - uniqueImageBytes
+    size_t stringBytes = 0;
+
+    // Undo/redo snapshots copy the documents but share their image buffers;
+    // only buffers the open documents no longer hold count here.
+    size_t undoStates = 0;
+    size_t undoBytes = 0;
+    size_t undoImageBytes = 0;
+    size_t redoStates = 0;
+    size_t redoBytes = 0;
+    size_t redoImageBytes = 0;
+};
+
+Report measure(const Session& session, size_t topSlides = 5);
+
+// "1.5 MB" style.
+std::string formatBytes(size_t bytes);
+
+} // namespace mem
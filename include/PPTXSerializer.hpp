@@ -1,18 +1,40 @@
 #pragma once
 #include "SlideShow.hpp"
+#include <atomic>
+#include <functional>
 #include <string>
 #include <vector>
-#include <map>
+
+// Optional hooks for long-running save/load. Both are used from the thread
+// running the operation. `onProgress` receives 0..1; when `cancel` becomes
+// true the operation stops, returns false and (for save) writes nothing.
+struct SerializerProgress {
+    std::function<void(double)> onProgress;
+    const std::atomic<bool>* cancel = nullptr;
+    // Set once the serializer gave up because of `cancel`. A request that
+    // arrives after the last check leaves it false: the work completed.
+    mutable bool stopped = false;
+
+    // Only asked where the serializer can stop; true means it stops there.
+    bool cancelled() const
+    {
+        if (cancel && cancel->load(std::memory_order_relaxed)) stopped = true;
+        return stopped;
+    }
+    void report(double f) const { if (onProgress) onProgress(f); }
+};
 
 class PPTXSerializer {
 public:
     static bool save(const std::vector<SlideShow>& slideshows,
                      const std::vector<std::string>& order,
-                     const std::string& outputFile);
+                     const std::string& outputFile,
+                     const SerializerProgress* progress = nullptr);
 
     static bool load(std::vector<SlideShow>& slideshows,
-                     std::map<std::string, size_t>& presentationIndex,
+                     PresentationIndex& presentationIndex,
                      std::vector<std::string>& presentationOrder,
                      size_t& currentIndex,
-                     const std::string& inputFile);
+                     const std::string& inputFile,
+                     const SerializerProgress* progress = nullptr);
 };
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Always-on phase timing. PROFILE_SCOPE(phase) times the rest of the
+// enclosing block and adds it to that phase's histogram; PROFILE_TIMER(name,
+// phase) does the same through a named timer whose stop() ends it early.
+// Recording is a few relaxed atomic increments, safe from any thread
+// (save/load run on workers). Phases may nest: "save" includes its "save.*"
+// sub-phases.
+//
+// Build with SLIDESHOW_NO_PROFILING to compile both out; code outside this
+// header should time through the macros only.
+namespace prof {
+
+enum class Phase : uint8_t {
+    Tokenize,
+    Parse,
+    Execute,
+    Snapshot,
+    RebuildIndex,
+    Save,
+    SaveXml,
+    SaveZipAdd,
+    SaveZipClose,
+    Load,
+    LoadRead,
+    LoadParse,
+    LoadMedia,
+    GuiRender,
+    GuiPaint,
+    Count
+};
+
+const char* phaseName(Phase p);
+
+struct PhaseStats
+{
+    Phase phase = Phase::Count;
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t p50Ns = 0;  // percentiles are bucket upper bounds (~12% resolution)
+    uint64_t p99Ns = 0;
+    uint64_t maxNs = 0;
+};
+
+inline uint64_t nowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(Phase p, uint64_t startNs, uint64_t endNs);
+
+// Phases with at least one sample, in enum order.
+std::vector<PhaseStats> collect();
+void reset();
+
+// Table of collect(); prints nothing if there are no samples.
+void report(std::ostream& os);
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Phase p) : phase_(p), start_(nowNs()) {}
+    ~ScopedTimer() { stop(); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    // Ends the measurement early; later calls (and the destructor) do nothing.
+    void stop()
+    {
+        if (stopped_) return;
+        stopped_ = true;
+        record(phase_, start_, nowNs());
+    }
+
+private:
+    Phase phase_;
+    uint64_t start_;
+    bool stopped_ = false;
+};
+
+// Stands in for ScopedTimer when profiling is compiled out.
+struct NullTimer
+{
+    void stop() {}
+};
+
+} // namespace prof
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef SLIDESHOW_NO_PROFILING
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_TIMER(name, phase) [[maybe_unused]] ::prof::NullTimer name
+#else
+#define PROFILE_SCOPE(phase) ::prof::ScopedTimer PROFILE_CONCAT(profScope_, __LINE__)(phase)
+#define PROFILE_TIMER(name, phase) ::prof::ScopedTimer name(phase)
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Shape;
+
+// Machine-readable output for listing commands (--output=json|tsv).
+enum class OutputFormat { Text, Json, Tsv };
+
+bool parseOutputFormat(const std::string& name, OutputFormat& out);
+
+// Process-wide; Text unless the CLI was started with --output.
+void setOutputFormat(OutputFormat format);
+OutputFormat outputFormat();
+
+// Writes records of one type through out(). Json emits one object per line
+// ({"type":"shape","slide":1,...}); Tsv emits a header row, then one row per
+// record with tabs/newlines in values escaped as \t, \n. Numbers are
+// formatted with to_chars and output leaves in blocks of about 64 KB, so
+// large listings avoid per-field iostream work.
+class RecordWriter
+{
+public:
+    RecordWriter(OutputFormat format, std::string type, std::initializer_list<const char*> columns);
+    ~RecordWriter();
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    // Values go to the columns in order; end() closes the record.
+    RecordWriter& field(int64_t value);
+    RecordWriter& field(std::string_view value);
+    RecordWriter& field(const char* value) { return field(std::string_view(value)); }
+    RecordWriter& null();  // Json null, empty Tsv cell
+    void end();
+
+    void flush();
+
+private:
+    void key();
+
+    OutputFormat format_;
+    std::string type_;
+    std::vector<const char*> columns_;
+    size_t column_ = 0;
+    std::string buf_;
+};
+
+// One "shape" record per shape (slide, index, id, kind, x, y, w, h, bytes,
+// text), the schema every shape listing uses.
+void writeShapeRecords(OutputFormat format, size_t slideNumber, const std::vector<Shape>& shapes);
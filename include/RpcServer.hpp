@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+
+// Local JSON-RPC server over a Unix domain socket (Linux, epoll).
+//
+// Each line a client sends is one JSON request; each answer is one JSON line:
+//
+//   {"id":1,"method":"execute","params":{"command":"add slide"}}
+//   {"id":2,"method":"add","params":["rect",10,10,100,50,"Title"]}
+//   {"id":3,"method":"state"}
+//
+// "execute" runs a command line; any other method name is a command keyword
+// whose params are appended as arguments. Results carry "ok", the command's
+// output lines and a summary of the session's document state.
+//
+// Every connection is its own session (documents, undo history, macros).
+// Undo history is capped per session, 100 states unless set otherwise.
+// Requests are handled on the thread that calls run(); only stop() may be
+// called from other threads. One server per process.
+class RpcServer
+{
+public:
+    explicit RpcServer(std::string socketPath);
+    ~RpcServer();
+
+    RpcServer(const RpcServer&) = delete;
+    RpcServer& operator=(const RpcServer&) = delete;
+
+    // Creates and binds the socket (replacing a stale socket file).
+    bool listen();
+
+    // Serves until stop() is called.
+    void run();
+
+    void stop();
+
+    // Undo states kept per client session; applies to clients accepted
+    // afterwards. 0 keeps all.
+    void setHistoryLimit(size_t states);
+
+private:
+    struct Connection;
+
+    void acceptClients();
+    void onReadable(Connection& c);
+    void onWritable(Connection& c);
+    void processLines(Connection& c);
+    void handleRequest(Connection& c, const std::string& line);
+    void pollTasks();
+    void closeConnection(int fd);
+    void updateInterest(Connection& c);
+
+private:
+    std::string path_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    std::atomic<bool> stopping_{false};
+    size_t historyLimit_ = 100;
+    std::map<int, std::unique_ptr<Connection>> conns_;
+};
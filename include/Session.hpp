@@ -0,0 +1,143 @@
+#pragma once
+
+#include "SlideShow.hpp"
+#include "ShapeTextIndex.hpp"
+#include "Macro.hpp"
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <map>
+#include <functional>
+
+// A change to the slides of the current presentation, reported after it
+// happened. Slide numbers are 0-based. Reset covers anything that is not
+// described precisely (open, undo/redo, adding a presentation).
+struct SlideEdit
+{
+    enum class Kind { Insert, Remove, Move, Change, Reset };
+
+    Kind kind = Kind::Reset;
+    size_t first = 0;  // Insert/Remove/Change: first slide; Move: from
+    size_t count = 0;  // Insert/Remove: number of slides; Move: to
+};
+
+// One independent editing session: open presentations, their order and
+// index, undo history, text search index and macros. Commands are bound to
+// the session they were parsed for, so separate sessions can be used from
+// separate threads (one thread per session at a time).
+class Session
+{
+public:
+    Session() = default;
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Slides and shapes may be edited through the mutable vector. Adding or
+    // removing presentations goes through the functions below, which keep
+    // the order and index current; code that changes the vector directly
+    // must call markPresentationsDirty().
+    std::vector<SlideShow>& getSlideshows();
+    const std::vector<SlideShow>& getSlideshows() const;
+
+    const std::vector<std::string>& getPresentationOrder() const;
+    const PresentationIndex& getPresentationIndex() const;
+
+    // Appends a presentation and makes it current. O(1) amortized.
+    void addPresentation(SlideShow ss);
+    // Replaces all open presentations (open/create). O(n).
+    void replacePresentations(std::vector<SlideShow> slideshows,
+                              std::vector<std::string> order,
+                              size_t currentIndex);
+    // Position of the presentation named `name`, or npos.
+    size_t findPresentation(const std::string& name) const;
+
+    void markPresentationsDirty();
+
+    size_t& getCurrentIndex();
+    size_t getCurrentIndex() const;
+
+    SlideShow& getCurrentSlideshow();
+    const SlideShow& getCurrentSlideshow() const;
+
+    // Brings order and index up to date after a command. Only does work
+    // when the presentation set was changed behind the session's back.
+    void rebuildUiIndex();
+
+    // Text search index over all open presentations. Commands that edit
+    // shapes keep it current through getTextIndex(); findText() brings it
+    // up to date first if it was marked stale.
+    ShapeTextIndex& getTextIndex();
+    std::vector<ShapeTextIndex::Hit> findText(const std::string& needle);
+
+    void setAutoSaveOnExit(bool on);
+    bool getAutoSaveOnExit() const;
+
+    void snapshot();
+    bool undo();
+    bool redo();
+
+    // Most undo states kept; snapshot() drops the oldest beyond it. Each
+    // state is a full copy of the documents. 0 (the default) keeps all.
+    void setHistoryLimit(size_t states);
+    size_t historyLimit() const;
+
+    size_t undoDepth() const;
+    size_t redoDepth() const;
+    // Calls `fn` with the documents of every undo (redo = false) and redo
+    // state, oldest first. Used for memory accounting.
+    void forEachHistoryState(const std::function<void(bool redo, const std::vector<SlideShow>&)>& fn) const;
+
+    // Lets a view follow slide edits row by row instead of re-reading the
+    // whole presentation; one listener, empty to stop.
+    void setSlideListener(std::function<void(const SlideEdit&)> fn);
+    void notifySlides(const SlideEdit& edit);
+
+    // Macro recording. While recording, CommandParser::parse hands every
+    // successfully parsed line to recordLine().
+    bool startRecording(const std::string& name);
+    bool isRecording() const;
+    const std::string& getRecordingName() const;
+    void recordLine(const std::string& line);
+    std::vector<std::string> stopRecording();
+
+    void setMacro(const std::string& name, Macro m);
+    Macro* findMacro(const std::string& name);
+
+private:
+    struct SnapshotState
+    {
+        std::vector<SlideShow> slideshows;
+        std::vector<std::string> order;
+        size_t currentIndex = 0;
+        bool autosaveOnExit = false;
+    };
+
+    SnapshotState packState() const;
+    void restoreState(const SnapshotState& st);
+
+    void normalizeCurrentIndex();
+    void ensureOrderIndexConsistent();
+
+private:
+    std::vector<SlideShow> slideshows_;
+    std::vector<std::string> presentationOrder_;
+    PresentationIndex presentationIndex_;
+    bool presentationsDirty_ = false;
+    size_t currentIndex_ = 0;
+    bool autosaveOnExit_ = false;
+
+    ShapeTextIndex textIndex_;
+
+    bool recording_ = false;
+    std::string recordingName_;
+    std::vector<std::string> recordedLines_;
+    std::map<std::string, Macro> macros_;
+
+    std::deque<SnapshotState> undo_;
+    std::vector<SnapshotState> redo_;
+    size_t historyLimit_ = 0;
+
+    std::function<void(const SlideEdit&)> slideListener_;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -11,9 +12,16 @@ enum class ShapeKind {
     Ellipse
 };
 
+// "Text", "Image", "Rect" or "Ellipse".
+const char* shapeKindName(ShapeKind k);
+
 class Shape
 {
 private:
+    // Stable identity: survives copies (undo snapshots, slide moves) so other
+    // structures can refer to a shape without relying on its vector position.
+    uint64_t id_ = 0;
+
     std::string name_;
     std::string text_;
 
@@ -23,7 +31,11 @@ private:
     int w_ = 220;
     int h_ = 80;
 
-    std::vector<uint8_t> imageData_;
+    // Image bytes never change once set, so copies of a shape (undo
+    // snapshots, slides handed to render workers) share one buffer.
+    std::shared_ptr<const std::vector<uint8_t>> imageData_;
+    // Content hash of the image bytes.
+    uint64_t imageHash_ = 0;
     
     // PowerPoint picture crop (DrawingML a:srcRect). Units are 1/1000 of a percent (0..100000).
     int cropL_ = 0;
@@ -41,6 +53,10 @@ public:
     Shape(std::string n, int px, int py, std::vector<uint8_t> data);
     Shape(std::string n, int px, int py, ShapeKind k, int w, int h);
 
+    uint64_t getId() const;
+    // Gives a copied shape its own identity (e.g. "duplicate shape").
+    void assignNewId();
+
     const std::string& getName() const;
     const std::string& getText() const;
 
@@ -58,6 +74,8 @@ public:
     ShapeKind kind() const;
 
     const std::vector<uint8_t>& getImageData() const;
+    // Identifies identical image payloads (with getImageData().size()).
+    uint64_t getImageHash() const;
     
     int getCropL() const;
     int getCropT() const;
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Shape;
+class SlideShow;
+
+// Inverted n-gram index over Shape::getText(), keyed by Shape::getId().
+// Lookups are case-insensitive (ASCII). Needles of three or more characters
+// intersect trigram postings and two-character ones read a bigram list. A
+// single character matches most shapes, so it scans the indexed texts.
+// Postings are sorted id vectors, so rebuilding is a sort per list and
+// intersecting is a merge.
+//
+// Commands keep it current with add/update/remove. Operations that replace
+// documents wholesale (open, undo, generate) call markStale(); the next
+// search reconciles the index with the documents by shape id, re-indexing
+// only shapes whose text differs.
+class ShapeTextIndex
+{
+public:
+    struct Location
+    {
+        size_t presentation = 0;
+        size_t slide = 0;
+        size_t shape = 0;
+    };
+
+    struct Hit
+    {
+        uint64_t id = 0;
+        Location where;
+    };
+
+    void clear();
+    // Drops everything; the next search rebuilds from scratch.
+    void invalidate();
+    void markStale();
+    bool isValid() const;
+    void rebuild(const std::vector<SlideShow>& slideshows);
+
+    void add(const Shape& sh);
+    void update(const Shape& sh);
+    void remove(uint64_t id);
+
+    // Sorted ids of indexed shapes whose text contains `needle`.
+    std::vector<uint64_t> find(const std::string& needle) const;
+
+    // find() on an index brought up to date with `slideshows`, with each
+    // hit's position, in document order. Positions are remembered, so a
+    // search costs O(hits) unless shapes moved since the last one.
+    std::vector<Hit> search(const std::vector<SlideShow>& slideshows, const std::string& needle);
+
+    size_t size() const;
+
+private:
+    struct Entry
+    {
+        std::string text;  // folded
+        Location where;
+        bool located = false;
+        uint32_t mark = 0;
+    };
+
+    static std::string fold(const std::string& s);
+    static bool sameFolded(const std::string& folded, const std::string& raw);
+    // Bigram and trigram keys of `folded`, in text order; a gram
+    // that occurs twice is listed twice.
+    static std::vector<uint32_t> grams(const std::string& folded);
+    // The keys a needle is looked up by.
+    static std::vector<uint32_t> needleGrams(const std::string& folded);
+
+    // Re-indexes shapes whose text changed, drops shapes that are gone and
+    // refreshes every position.
+    void sync(const std::vector<SlideShow>& slideshows);
+    bool resolve(const std::vector<SlideShow>& slideshows, const std::vector<uint64_t>& ids,
+                 std::vector<Hit>& out) const;
+
+    void insertFolded(uint64_t id, std::string folded, const Location* where);
+    void erase(uint64_t id);
+
+    std::vector<uint64_t>& listFor(uint32_t key);
+    const std::vector<uint64_t>* findList(uint32_t key) const;
+
+private:
+    // Bigram postings sit in a flat table indexed by the two bytes; the
+    // sparse trigrams in a map.
+    std::vector<std::vector<uint64_t>> bigrams_;
+    std::unordered_map<uint32_t, std::vector<uint64_t>> trigrams_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    bool valid_ = false;
+    bool stale_ = false;
+    uint32_t mark_ = 0;
+};
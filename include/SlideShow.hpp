@@ -1,6 +1,7 @@
 #pragma once
 #include "Slide.hpp"
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class SlideShow {
@@ -30,3 +31,6 @@ public:
     SlideShow(const SlideShow&) = default;
     SlideShow& operator=(const SlideShow&) = default;
 };
+
+// Presentation filename -> position in the list of open slideshows.
+using PresentationIndex = std::unordered_map<std::string, size_t>;
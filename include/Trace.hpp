@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Chrome trace-event recording (chrome://tracing, Perfetto). While a trace
+// is running every profiler scope (Profiler.hpp) also becomes a complete
+// ("X") event on its thread. Events go to a buffer owned by the recording
+// thread, so recording takes no locks; stopTrace() collects all threads'
+// buffers and writes the JSON file.
+namespace prof {
+
+namespace detail {
+extern std::atomic<bool> g_tracing;
+void traceEvent(const char* name, uint64_t startNs, uint64_t endNs);
+}
+
+inline bool isTracing() { return detail::g_tracing.load(std::memory_order_relaxed); }
+
+// `name` must outlive the trace (string literals, phaseName()).
+inline void traceEvent(const char* name, uint64_t startNs, uint64_t endNs)
+{
+    if (isTracing()) detail::traceEvent(name, startNs, endNs);
+}
+
+// Label for the calling thread in traces ("main", "worker: save a.pptx").
+void setThreadName(const std::string& name);
+
+// Begins recording into `path` (checked for writability now, written by
+// stopTrace). Fails if a trace is already running.
+bool startTrace(const std::string& path, std::string* err = nullptr);
+
+// Ends recording and writes the file. `events` receives the number of
+// events written, `dropped` those lost to the per-thread limit.
+bool stopTrace(size_t* events = nullptr, size_t* dropped = nullptr, std::string* err = nullptr);
+
+// Path of the running trace, or empty.
+std::string tracePath();
+
+} // namespace prof
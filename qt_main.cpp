@@ -1,11 +1,13 @@
 #include <QApplication>
 #include "gui/MainWindow.hpp"
+#include "Trace.hpp"
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
     QApplication::setApplicationName("SlideShowGUI");
     QApplication::setOrganizationName("SlideShow");
+    prof::setThreadName("gui");
 
     MainWindow w;
     w.resize(1100, 700);
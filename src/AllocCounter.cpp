@@ -0,0 +1,84 @@
+#include "AllocCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace alloc {
+namespace {
+// Constant-initialized, so touching it never allocates.
+thread_local Counts t_counts;
+}
+
+#ifdef SLIDESHOW_ALLOC_COUNTING
+bool enabled() { return true; }
+#else
+bool enabled() { return false; }
+#endif
+
+Counts threadCounts() { return t_counts; }
+
+} // namespace alloc
+
+#ifdef SLIDESHOW_ALLOC_COUNTING
+
+namespace {
+
+void* countedAlloc(std::size_t n)
+{
+    if (n == 0) n = 1;
+    alloc::t_counts.allocs++;
+    alloc::t_counts.bytes += n;
+    return std::malloc(n);
+}
+
+void* countedAlignedAlloc(std::size_t n, std::align_val_t al)
+{
+    const std::size_t a = static_cast<std::size_t>(al);
+    if (n == 0) n = a;
+    alloc::t_counts.allocs++;
+    alloc::t_counts.bytes += n;
+    return std::aligned_alloc(a, (n + a - 1) / a * a);
+}
+
+void countedFree(void* p)
+{
+    if (!p) return;
+    alloc::t_counts.frees++;
+    std::free(p);
+}
+
+} // namespace
+
+void* operator new(std::size_t n)
+{
+    if (void* p = countedAlloc(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n); }
+
+void* operator new(std::size_t n, std::align_val_t al)
+{
+    if (void* p = countedAlignedAlloc(n, al)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n, std::align_val_t al) { return operator new(n, al); }
+void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept { return countedAlignedAlloc(n, al); }
+void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept { return countedAlignedAlloc(n, al); }
+
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedFree(p); }
+
+#endif
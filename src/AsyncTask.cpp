@@ -0,0 +1,72 @@
+#include "AsyncTask.hpp"
+#include "Profiler.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+AsyncTask::AsyncTask(std::string label, Work work, Finish finish)
+    : label_(std::move(label)), work_(std::move(work)), finish_(std::move(finish)) {}
+
+AsyncTask::~AsyncTask()
+{
+    if (result_.valid()) {
+        cancel();
+        result_.wait();
+    }
+}
+
+void AsyncTask::start()
+{
+    if (result_.valid()) return;
+    result_ = std::async(std::launch::async, [this]() {
+        prof::setThreadName("worker: " + label_);
+        const uint64_t t0 = prof::nowNs();
+        const Result r = work_(*this);
+        prof::traceEvent("async task", t0, prof::nowNs());
+        return r;
+    });
+}
+
+bool AsyncTask::isReady() const
+{
+    if (!result_.valid()) return completed_;
+    return result_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void AsyncTask::wait() const
+{
+    if (result_.valid()) result_.wait();
+}
+
+void AsyncTask::complete()
+{
+    if (completed_) return;
+    Result r = Result::Failed;
+    if (result_.valid()) r = result_.get();
+    completed_ = true;
+    if (finish_) finish_(r == Result::Done, r == Result::Cancelled);
+}
+
+bool AsyncTask::isCompleted() const { return completed_; }
+
+void AsyncTask::cancel() { cancel_.store(true, std::memory_order_relaxed); }
+bool AsyncTask::isCancelled() const { return cancel_.load(std::memory_order_relaxed); }
+const std::atomic<bool>& AsyncTask::cancelFlag() const { return cancel_; }
+
+void AsyncTask::setProgress(double fraction)
+{
+    const int pct = static_cast<int>(std::lround(std::clamp(fraction, 0.0, 1.0) * 100.0));
+    progress_.store(pct, std::memory_order_relaxed);
+}
+
+int AsyncTask::progressPercent() const { return progress_.load(std::memory_order_relaxed); }
+
+const std::string& AsyncTask::label() const { return label_; }
+
+void IAsyncCommand::execute()
+{
+    std::shared_ptr<AsyncTask> task = startAsync();
+    if (task) task->complete();
+}
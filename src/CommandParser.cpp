@@ -2,24 +2,26 @@
 #include "../include/Commands.hpp"
 #include "../include/Tokenizer.hpp"
 #include "../include/Controller.hpp"
+#include "../include/Profiler.hpp"
+#include "../include/Log.hpp"
 
 #include <iostream>
 #include <algorithm>
 
-std::unique_ptr<ICommand> CommandParser::parse(std::istream& in)
+namespace {
+
+std::unique_ptr<ICommand> parseLine(const std::string& line, Session& session)
 {
-    std::string line;
-    if (!std::getline(in, line)) {
-        return std::unique_ptr<ICommand>(new CommandExit());
+    std::vector<Token> tokens;
+    {
+        PROFILE_SCOPE(prof::Phase::Tokenize);
+        tokens = Tokenizer::tokenizeCommandLine(line);
     }
-    if (line.empty()) return nullptr;
-
-    auto tokens = Tokenizer::tokenizeCommandLine(line);
     if (tokens.empty()) return nullptr;
 
     const Token& cmdTok = tokens[0];
     if (!cmdTok.isCommand()) {
-        std::cout << "[ERR] First token must be command\n";
+        error() << "First token must be command\n";
         return nullptr;
     }
 
@@ -34,8 +36,6 @@ std::unique_ptr<ICommand> CommandParser::parse(std::istream& in)
         else args.push_back(t.asString());
     }
 
-    auto& ctrl = Controller::instance();
-
     // Aliases
     if (cmd == "del" || cmd == "delete") cmd = "remove";
     if (cmd == "ls") cmd = "list";
@@ -46,35 +46,35 @@ std::unique_ptr<ICommand> CommandParser::parse(std::istream& in)
     // Presentation-level
     if (cmd == "create" && !args.empty() && args[0] == "slideshow") {
         std::vector<std::string> name(args.begin() + 1, args.end());
-        return std::unique_ptr<ICommand>(new CommandCreateSlideshow(ctrl, name));
+        return std::unique_ptr<ICommand>(new CommandCreateSlideshow(session, name));
     }
-    if (cmd == "open") return std::unique_ptr<ICommand>(new CommandOpen(ctrl, args));
+    if (cmd == "open") return std::unique_ptr<ICommand>(new CommandOpen(session, args));
 
     if (cmd == "save") {
         if (args.empty()) {
-            std::cout << "[ERR] Usage: save <file.pptx>\n";
+            error() << "Usage: save <file.pptx>\n";
             return nullptr;
         }
-        return std::unique_ptr<ICommand>(new CommandSave(args[0]));
+        return std::unique_ptr<ICommand>(new CommandSave(session, args[0]));
     }
 
-    if (cmd == "autosave") return std::unique_ptr<ICommand>(new CommandAutoSave(ctrl, args));
-    if (cmd == "nextfile") return std::unique_ptr<ICommand>(new CommandNextFile(ctrl));
-    if (cmd == "prevfile") return std::unique_ptr<ICommand>(new CommandPrevFile(ctrl));
+    if (cmd == "autosave") return std::unique_ptr<ICommand>(new CommandAutoSave(session, args));
+    if (cmd == "nextfile") return std::unique_ptr<ICommand>(new CommandNextFile(session));
+    if (cmd == "prevfile") return std::unique_ptr<ICommand>(new CommandPrevFile(session));
 
     // Slide-level
     if (cmd == "add" && !args.empty() && args[0] == "slide") {
-        if (ctrl.getSlideshows().empty()) {
-            std::cout << "[ERR] No presentation loaded. Use 'create slideshow <name>' or 'open <file.pptx>' first.\n";
+        if (session.getSlideshows().empty()) {
+            error() << "No presentation loaded. Use 'create slideshow <name>' or 'open <file.pptx>' first.\n";
             return nullptr;
         }
         std::vector<std::string> slideArgs(args.begin() + 1, args.end());
-        return std::unique_ptr<ICommand>(new CommandAddSlide(ctrl, slideArgs));
+        return std::unique_ptr<ICommand>(new CommandAddSlide(session, slideArgs));
     }
 
     // Shape-level
     if (cmd == "list" && !args.empty() && args[0] == "shapes") {
-        return std::unique_ptr<ICommand>(new CommandListShapes(ctrl));
+        return std::unique_ptr<ICommand>(new CommandListShapes(session));
     }
 
     if (cmd == "add" && !args.empty()) {
@@ -86,49 +86,93 @@ std::unique_ptr<ICommand> CommandParser::parse(std::istream& in)
         //   add shape rect ...
         if (args[0] == "shape" && args.size() >= 2) {
             std::vector<std::string> a(args.begin() + 1, args.end());
-            return std::unique_ptr<ICommand>(new CommandAddShape(ctrl, a));
+            return std::unique_ptr<ICommand>(new CommandAddShape(session, a));
         }
         if (args[0] == "rect" || args[0] == "ellipse" || args[0] == "text" || args[0] == "image") {
-            return std::unique_ptr<ICommand>(new CommandAddShape(ctrl, args));
+            return std::unique_ptr<ICommand>(new CommandAddShape(session, args));
         }
     }
 
     if (cmd == "remove" && !args.empty() && args[0] == "shape") {
-        return std::unique_ptr<ICommand>(new CommandRemoveShape(ctrl, args));
+        return std::unique_ptr<ICommand>(new CommandRemoveShape(session, args));
     }
     if (cmd == "move" && !args.empty() && args[0] == "shape") {
-        return std::unique_ptr<ICommand>(new CommandMoveShape(ctrl, args));
+        return std::unique_ptr<ICommand>(new CommandMoveShape(session, args));
     }
     if (cmd == "resize" && !args.empty() && args[0] == "shape") {
-        return std::unique_ptr<ICommand>(new CommandResizeShape(ctrl, args));
+        return std::unique_ptr<ICommand>(new CommandResizeShape(session, args));
     }
     if (cmd == "text" && !args.empty() && args[0] == "shape") {
-        return std::unique_ptr<ICommand>(new CommandSetShapeText(ctrl, args));
+        return std::unique_ptr<ICommand>(new CommandSetShapeText(session, args));
     }
     if ((cmd == "dup" || cmd == "duplicate") && !args.empty() && args[0] == "shape") {
-        return std::unique_ptr<ICommand>(new CommandDuplicateShape(ctrl, args));
+        return std::unique_ptr<ICommand>(new CommandDuplicateShape(session, args));
+    }
+    if (cmd == "find" && !args.empty() && args[0] == "shapes") {
+        return std::unique_ptr<ICommand>(new CommandFindShapes(session, args));
+    }
+    if (cmd == "stats") return std::unique_ptr<ICommand>(new CommandStats(args));
+    if (cmd == "trace") return std::unique_ptr<ICommand>(new CommandTrace(args));
+    if (cmd == "mem") return std::unique_ptr<ICommand>(new CommandMem(session, args));
+    if (cmd == "generate" && !args.empty() && args[0] == "deck") {
+        return std::unique_ptr<ICommand>(new CommandGenerateDeck(session, args));
     }
 
     // Navigation / show
-    if (ctrl.getSlideshows().empty() &&
+    if (session.getSlideshows().empty() &&
         (cmd == "remove" || cmd == "move" || cmd == "goto" ||
          cmd == "next" || cmd == "prev" || cmd == "show"))
     {
-        std::cout << "[ERR] No presentation loaded.\n";
+        error() << "No presentation loaded.\n";
         return nullptr;
     }
 
-    if (cmd == "remove") return std::unique_ptr<ICommand>(new CommandRemoveSlide(ctrl, args));
-    if (cmd == "move") return std::unique_ptr<ICommand>(new CommandMoveSlide(ctrl, args));
-    if (cmd == "goto") return std::unique_ptr<ICommand>(new CommandGotoSlide(ctrl, args));
-    if (cmd == "next") return std::unique_ptr<ICommand>(new CommandNext(ctrl.getCurrentSlideshow()));
-    if (cmd == "prev") return std::unique_ptr<ICommand>(new CommandPrev(ctrl.getCurrentSlideshow()));
-    if (cmd == "show") return std::unique_ptr<ICommand>(new CommandShow(ctrl.getCurrentSlideshow()));
+    if (cmd == "remove") return std::unique_ptr<ICommand>(new CommandRemoveSlide(session, args));
+    if (cmd == "move") return std::unique_ptr<ICommand>(new CommandMoveSlide(session, args));
+    if (cmd == "goto") return std::unique_ptr<ICommand>(new CommandGotoSlide(session, args));
+    if (cmd == "next") return std::unique_ptr<ICommand>(new CommandNext(session));
+    if (cmd == "prev") return std::unique_ptr<ICommand>(new CommandPrev(session));
+    if (cmd == "show") return std::unique_ptr<ICommand>(new CommandShow(session));
+
+    if (cmd == "preview") return std::unique_ptr<ICommand>(new CommandPreview(session));
+    if (cmd == "undo") return std::unique_ptr<ICommand>(new CommandUndo(session));
+    if (cmd == "redo") return std::unique_ptr<ICommand>(new CommandRedo(session));
 
-    if (cmd == "preview") return std::unique_ptr<ICommand>(new CommandPreview(ctrl));
-    if (cmd == "undo") return std::unique_ptr<ICommand>(new CommandUndo(ctrl));
-    if (cmd == "redo") return std::unique_ptr<ICommand>(new CommandRedo(ctrl));
+    // Macros
+    if (cmd == "record") return std::unique_ptr<ICommand>(new CommandRecordMacro(session, args));
+    if (cmd == "stop") return std::unique_ptr<ICommand>(new CommandStopRecording(session));
+    if (cmd == "play") return std::unique_ptr<ICommand>(new CommandPlayMacro(session, args));
 
-    std::cout << "[ERR] Unknown command: " << cmd << "\n";
+    error() << "Unknown command: " << cmd << "\n";
     return nullptr;
 }
+
+} // namespace
+
+std::unique_ptr<ICommand> CommandParser::parse(std::istream& in)
+{
+    return parse(in, Controller::instance());
+}
+
+std::unique_ptr<ICommand> CommandParser::parse(std::istream& in, Session& session)
+{
+    std::string line;
+    if (!std::getline(in, line)) {
+        return std::unique_ptr<ICommand>(new CommandExit());
+    }
+    if (line.empty()) return nullptr;
+
+    PROFILE_SCOPE(prof::Phase::Parse);
+    std::unique_ptr<ICommand> cmd = parseLine(line, session);
+
+    // Macro control commands are never part of a recording, nor are lines
+    // whose arguments do not parse (execute() reports those).
+    if (cmd && session.isRecording() && cmd->argumentError().empty() &&
+        !dynamic_cast<CommandRecordMacro*>(cmd.get()) &&
+        !dynamic_cast<CommandStopRecording*>(cmd.get()) &&
+        !dynamic_cast<CommandPlayMacro*>(cmd.get()))
+    {
+        session.recordLine(line);
+    }
+    return cmd;
+}
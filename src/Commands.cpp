@@ -1,11 +1,17 @@
 #include "Commands.hpp"
 
-#include "Controller.hpp"
+#include "Session.hpp"
+#include "DeckGenerator.hpp"
+#include "MemoryStats.hpp"
+#include "RecordWriter.hpp"
+#include "Profiler.hpp"
+#include "Trace.hpp"
 #include "SlideShow.hpp"
 #include "Slide.hpp"
 #include "Shape.hpp"
-#include "Color.hpp"
+#include "Log.hpp"
 
+#include "CommandParser.hpp"
 #include "PPTXSerializer.hpp"
 #include "Functions.hpp"
 
@@ -43,6 +49,18 @@ bool parseInt(const std::string& s, int& out) {
     }
 }
 
+bool parseDouble(const std::string& s, double& out) {
+    try {
+        size_t pos = 0;
+        double v = std::stod(s, &pos);
+        if (pos != s.size()) return false;
+        out = v;
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
 std::string joinFrom(const std::vector<std::string>& a, size_t i) {
     std::string r;
     for (size_t k = i; k < a.size(); ++k) {
@@ -52,18 +70,20 @@ std::string joinFrom(const std::vector<std::string>& a, size_t i) {
     return r;
 }
 
-bool ensureCurrentSlide(Controller& ctrl, SlideShow*& outSS, Slide*& outSlide) {
-    if (ctrl.getSlideshows().empty()) {
+// Callers edit the slide unless `edit` is false; it is reported as changed.
+bool ensureCurrentSlide(Session& session, SlideShow*& outSS, Slide*& outSlide, bool edit = true) {
+    if (session.getSlideshows().empty()) {
         error() << "No presentation loaded. Use 'create slideshow <name>' or 'open <file.pptx>' first.\n";
         return false;
     }
-    SlideShow& ss = ctrl.getCurrentSlideshow();
+    SlideShow& ss = session.getCurrentSlideshow();
     if (ss.getSlides().empty()) {
         error() << "No slides. Use 'add slide' first.\n";
         return false;
     }
     outSS = &ss;
     outSlide = &ss.getSlides()[ss.getCurrentIndex()];
+    if (edit) session.notifySlides({SlideEdit::Kind::Change, ss.getCurrentIndex(), 1});
     return true;
 }
 
@@ -97,6 +117,22 @@ bool loadAnyImageAsPngBytes(const std::string& path,
 
 } // namespace
 
+bool isUndoableCommand(const ICommand* cmd) {
+    return
+        dynamic_cast<const CommandCreateSlideshow*>(cmd) ||
+        dynamic_cast<const CommandAddSlide*>(cmd) ||
+        dynamic_cast<const CommandRemoveSlide*>(cmd) ||
+        dynamic_cast<const CommandMoveSlide*>(cmd) ||
+        dynamic_cast<const CommandAddShape*>(cmd) ||
+        dynamic_cast<const CommandRemoveShape*>(cmd) ||
+        dynamic_cast<const CommandMoveShape*>(cmd) ||
+        dynamic_cast<const CommandResizeShape*>(cmd) ||
+        dynamic_cast<const CommandSetShapeText*>(cmd) ||
+        dynamic_cast<const CommandDuplicateShape*>(cmd) ||
+        dynamic_cast<const CommandPlayMacro*>(cmd) ||
+        dynamic_cast<const CommandGenerateDeck*>(cmd);
+}
+
 // -------------------------
 // Basic commands
 // -------------------------
@@ -106,7 +142,7 @@ void CommandExit::execute() {
 }
 
 void CommandHelp::execute() {
-    std::cout
+    out()
         << "Commands:\n"
         << "  help\n"
         << "  exit\n"
@@ -123,6 +159,7 @@ void CommandHelp::execute() {
         << "  show\n"
         << "  preview\n"
         << "  undo / redo\n"
+        << "  record <name> / stop / play <name> [times]\n"
         << "\nShape commands:\n"
         << "  list shapes\n"
         << "  add rect <x> <y> <w> <h> [text...]\n"
@@ -133,11 +170,18 @@ void CommandHelp::execute() {
         << "  move shape <idx> <x> <y>\n"
         << "  resize shape <idx> <w> <h>\n"
         << "  text shape <idx> [text...]\n"
-        << "  duplicate shape <idx> [dx dy]\n";
+        << "  duplicate shape <idx> [dx dy]\n"
+        << "  find shapes where text~\"...\" [in all slides|in all presentations]\n"
+        << "\nDiagnostics:\n"
+        << "  stats [reset]\n"
+        << "  trace start <file.json> / trace stop\n"
+        << "  mem [top=N]\n"
+        << "\nTesting:\n"
+        << "  generate deck <slides> <shapes> [images=N dup=P seed=S words=W imgsize=PX name=NAME]\n";
 }
 
-CommandCreateSlideshow::CommandCreateSlideshow(Controller& c, const std::vector<std::string>& name)
-    : ctrl(c), nameTokens(name) {}
+CommandCreateSlideshow::CommandCreateSlideshow(Session& c, const std::vector<std::string>& name)
+    : session(c), nameTokens(name) {}
 
 void CommandCreateSlideshow::execute() {
     std::string name;
@@ -147,59 +191,71 @@ void CommandCreateSlideshow::execute() {
     }
     if (name.empty()) name = "Presentation";
 
-    ctrl.getSlideshows().clear();
-    ctrl.getPresentationOrder().clear();
-    ctrl.getPresentationIndex().clear();
-
-    ctrl.getSlideshows().push_back(SlideShow(name));
-    ctrl.getPresentationOrder().push_back(name);
-    ctrl.getCurrentIndex() = 0;
-    ctrl.rebuildUiIndex();
+    std::vector<SlideShow> shows;
+    shows.emplace_back(name);
+    session.replacePresentations(std::move(shows), {name}, 0);
+    session.getTextIndex().markStale();
 
     success() << "Created slideshow: " << name << "\n";
 }
 
-CommandOpen::CommandOpen(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
+CommandOpen::CommandOpen(Session& c, const std::vector<std::string>& a)
+    : session(c), args(a) {}
 
-void CommandOpen::execute() {
+std::shared_ptr<AsyncTask> CommandOpen::startAsync() {
     if (args.empty()) {
         error() << "Usage: open <file.pptx>\n";
-        return;
+        return nullptr;
     }
     const std::string file = args[0];
 
-    std::vector<SlideShow> slideshows;
-    std::map<std::string, size_t> index;
-    std::vector<std::string> order;
-    size_t currentIndex = 0;
-
-    if (!PPTXSerializer::load(slideshows, index, order, currentIndex, file)) {
-        error() << "Failed to open PPTX: " << file << "\n";
-        return;
-    }
-
-    ctrl.getSlideshows() = std::move(slideshows);
-    ctrl.getPresentationIndex() = std::move(index);
-    ctrl.getPresentationOrder() = std::move(order);
-
-    if (ctrl.getSlideshows().empty()) {
-        ctrl.getCurrentIndex() = 0;
-    } else if (currentIndex >= ctrl.getSlideshows().size()) {
-        ctrl.getCurrentIndex() = 0;
-    } else {
-        ctrl.getCurrentIndex() = currentIndex;
-    }
+    struct Loaded {
+        std::vector<SlideShow> slideshows;
+        PresentationIndex index;
+        std::vector<std::string> order;
+        size_t currentIndex = 0;
+    };
+    auto loaded = std::make_shared<Loaded>();
+    Session& c = session;
+
+    auto task = std::make_shared<AsyncTask>("open " + file,
+        [loaded, file](AsyncTask& t) {
+            SerializerProgress p;
+            p.onProgress = [&t](double f) { t.setProgress(f); };
+            p.cancel = &t.cancelFlag();
+            if (PPTXSerializer::load(loaded->slideshows, loaded->index, loaded->order,
+                                     loaded->currentIndex, file, &p))
+                return AsyncTask::Result::Done;
+            return p.stopped ? AsyncTask::Result::Cancelled : AsyncTask::Result::Failed;
+        },
+        [loaded, file, &c](bool ok, bool cancelled) {
+            if (cancelled) {
+                info() << "Open cancelled: " << file << "\n";
+                return;
+            }
+            if (!ok) {
+                error() << "Failed to open PPTX: " << file << "\n";
+                return;
+            }
 
-    ctrl.rebuildUiIndex();
-    success() << "Opened: " << file << "\n";
+            // The undo point is taken here rather than when the command is
+            // issued: edits made while the file was loading belong to it.
+            c.snapshot();
+
+            // Out-of-range current index is reset to 0 by the session.
+            c.replacePresentations(std::move(loaded->slideshows), std::move(loaded->order),
+                                   loaded->currentIndex);
+            c.getTextIndex().markStale();
+            success() << "Opened: " << file << "\n";
+        });
+    task->start();
+    return task;
 }
 
-CommandSave::CommandSave(const std::string& f) : file(f) {}
+CommandSave::CommandSave(Session& s, const std::string& f) : session(s), file(f) {}
 
 void CommandSave::execute() {
-    auto& ctrl = Controller::instance();
-    if (ctrl.getSlideshows().empty()) {
+    if (session.getSlideshows().empty()) {
         error() << "Nothing to save (no presentation loaded)\n";
         return;
     }
@@ -208,100 +264,146 @@ void CommandSave::execute() {
         return;
     }
 
-    if (!PPTXSerializer::save(ctrl.getSlideshows(), ctrl.getPresentationOrder(), file)) {
+    if (!PPTXSerializer::save(session.getSlideshows(), session.getPresentationOrder(), file)) {
         error() << "Failed to save: " << file << "\n";
         return;
     }
     success() << "Saved: " << file << "\n";
 }
 
-CommandAutoSave::CommandAutoSave(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
+std::shared_ptr<AsyncTask> CommandSave::startAsync() {
+    if (session.getSlideshows().empty()) {
+        error() << "Nothing to save (no presentation loaded)\n";
+        return nullptr;
+    }
+    if (file.empty()) {
+        error() << "Usage: save <file.pptx>\n";
+        return nullptr;
+    }
+
+    // The worker saves a copy, so editing can continue while it runs.
+    auto slideshows = std::make_shared<const std::vector<SlideShow>>(session.getSlideshows());
+    auto order = std::make_shared<const std::vector<std::string>>(session.getPresentationOrder());
+    const std::string f = file;
+
+    auto task = std::make_shared<AsyncTask>("save " + f,
+        [slideshows, order, f](AsyncTask& t) {
+            SerializerProgress p;
+            p.onProgress = [&t](double v) { t.setProgress(v); };
+            p.cancel = &t.cancelFlag();
+            if (PPTXSerializer::save(*slideshows, *order, f, &p)) return AsyncTask::Result::Done;
+            return p.stopped ? AsyncTask::Result::Cancelled : AsyncTask::Result::Failed;
+        },
+        [f](bool ok, bool cancelled) {
+            if (cancelled) info() << "Save cancelled: " << f << "\n";
+            else if (!ok) error() << "Failed to save: " << f << "\n";
+            else success() << "Saved: " << f << "\n";
+        });
+    task->start();
+    return task;
+}
+
+CommandAutoSave::CommandAutoSave(Session& c, const std::vector<std::string>& a)
+    : session(c) {
+    if (a.empty()) {
+        query = true;
+        return;
+    }
+    const std::string v = toLower(a[0]);
+    if (v == "on" || v == "1" || v == "true") on = true;
+    else if (v == "off" || v == "0" || v == "false") on = false;
+    else argError = "Usage: autosave on|off";
+}
 
 void CommandAutoSave::execute() {
-    if (args.empty()) {
-        info() << "autosave is " << (ctrl.getAutoSaveOnExit() ? "on" : "off") << "\n";
+    if (!argError.empty()) {
+        error() << argError << "\n";
         return;
     }
-    std::string v = toLower(args[0]);
-    if (v == "on" || v == "1" || v == "true") ctrl.setAutoSaveOnExit(true);
-    else if (v == "off" || v == "0" || v == "false") ctrl.setAutoSaveOnExit(false);
-    else {
-        error() << "Usage: autosave on|off\n";
+    if (query) {
+        info() << "autosave is " << (session.getAutoSaveOnExit() ? "on" : "off") << "\n";
         return;
     }
-    success() << "autosave is now " << (ctrl.getAutoSaveOnExit() ? "on" : "off") << "\n";
+    session.setAutoSaveOnExit(on);
+    success() << "autosave is now " << (session.getAutoSaveOnExit() ? "on" : "off") << "\n";
 }
 
-CommandNextFile::CommandNextFile(Controller& c) : ctrl(c) {}
+CommandNextFile::CommandNextFile(Session& c) : session(c) {}
 void CommandNextFile::execute() {
-    if (ctrl.getSlideshows().empty()) {
+    if (session.getSlideshows().empty()) {
         error() << "No presentation loaded.\n";
         return;
     }
-    size_t& idx = ctrl.getCurrentIndex();
-    const size_t n = ctrl.getSlideshows().size();
+    size_t& idx = session.getCurrentIndex();
+    const size_t n = session.getSlideshows().size();
     idx = (idx + 1) % n;
-    ctrl.rebuildUiIndex();
+    session.rebuildUiIndex();
+    session.notifySlides({SlideEdit::Kind::Reset});
     info() << "Switched to presentation " << (idx + 1) << " / " << n << "\n";
 }
 
-CommandPrevFile::CommandPrevFile(Controller& c) : ctrl(c) {}
+CommandPrevFile::CommandPrevFile(Session& c) : session(c) {}
 void CommandPrevFile::execute() {
-    if (ctrl.getSlideshows().empty()) {
+    if (session.getSlideshows().empty()) {
         error() << "No presentation loaded.\n";
         return;
     }
-    size_t& idx = ctrl.getCurrentIndex();
-    const size_t n = ctrl.getSlideshows().size();
+    size_t& idx = session.getCurrentIndex();
+    const size_t n = session.getSlideshows().size();
     idx = (idx + n - 1) % n;
-    ctrl.rebuildUiIndex();
+    session.rebuildUiIndex();
+    session.notifySlides({SlideEdit::Kind::Reset});
     info() << "Switched to presentation " << (idx + 1) << " / " << n << "\n";
 }
 
-CommandAddSlide::CommandAddSlide(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
+CommandAddSlide::CommandAddSlide(Session& c, const std::vector<std::string>& a)
+    : session(c), args(a) {}
 
 void CommandAddSlide::execute() {
-    if (ctrl.getSlideshows().empty()) {
+    if (session.getSlideshows().empty()) {
         error() << "No presentation loaded.\n";
         return;
     }
-    SlideShow& ss = ctrl.getCurrentSlideshow();
+    SlideShow& ss = session.getCurrentSlideshow();
 
     Slide slide;
     ss.getSlides().push_back(slide);
     ss.setCurrentIndex(ss.getSlides().size() - 1);
+    session.notifySlides({SlideEdit::Kind::Insert, ss.getSlides().size() - 1, 1});
 
     success() << "Added slide. Total: " << ss.getSlides().size() << "\n";
 }
 
-CommandRemoveSlide::CommandRemoveSlide(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
+CommandRemoveSlide::CommandRemoveSlide(Session& c, const std::vector<std::string>& a)
+    : session(c) {
+    if (a.empty()) argError = "Usage: remove <slideIndex>";
+    else if (!parseInt(a[0], idx)) argError = "Invalid slide index.";
+}
 
 void CommandRemoveSlide::execute() {
-    if (ctrl.getSlideshows().empty()) {
+    if (session.getSlideshows().empty()) {
         error() << "No presentation loaded.\n";
         return;
     }
-    SlideShow& ss = ctrl.getCurrentSlideshow();
+    SlideShow& ss = session.getCurrentSlideshow();
     if (ss.getSlides().empty()) {
         error() << "No slides.\n";
         return;
     }
 
-    if (args.empty()) {
-        error() << "Usage: remove <slideIndex>\n";
+    if (!argError.empty()) {
+        error() << argError << "\n";
         return;
     }
-
-    int idx = 0;
-    if (!parseInt(args[0], idx) || idx < 1 || (size_t)idx > ss.getSlides().size()) {
+    if (idx < 1 || (size_t)idx > ss.getSlides().size()) {
         error() << "Invalid slide index.\n";
         return;
     }
 
+    for (const auto& sh : ss.getSlides()[(size_t)idx - 1].getShapes())
+        session.getTextIndex().remove(sh.getId());
     ss.getSlides().erase(ss.getSlides().begin() + (idx - 1));
+    session.notifySlides({SlideEdit::Kind::Remove, (size_t)idx - 1, 1});
 
     if (ss.getSlides().empty()) ss.setCurrentIndex(0);
     else if (ss.getCurrentIndex() >= ss.getSlides().size())
@@ -310,27 +412,24 @@ void CommandRemoveSlide::execute() {
     success() << "Removed slide " << idx << "\n";
 }
 
-CommandMoveSlide::CommandMoveSlide(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
+CommandMoveSlide::CommandMoveSlide(Session& c, const std::vector<std::string>& a)
+    : session(c) {
+    if (a.size() < 2) argError = "Usage: move <fromIndex> <toIndex>";
+    else if (!parseInt(a[0], from) || !parseInt(a[1], to)) argError = "Invalid indices.";
+}
 
 void CommandMoveSlide::execute() {
-    if (ctrl.getSlideshows().empty()) {
+    if (session.getSlideshows().empty()) {
         error() << "No presentation loaded.\n";
         return;
     }
-    SlideShow& ss = ctrl.getCurrentSlideshow();
+    SlideShow& ss = session.getCurrentSlideshow();
     if (ss.getSlides().empty()) {
         error() << "No slides.\n";
         return;
     }
-    if (args.size() < 2) {
-        error() << "Usage: move <fromIndex> <toIndex>\n";
-        return;
-    }
-
-    int from = 0, to = 0;
-    if (!parseInt(args[0], from) || !parseInt(args[1], to)) {
-        error() << "Invalid indices.\n";
+    if (!argError.empty()) {
+        error() << argError << "\n";
         return;
     }
     if (from < 1 || to < 1 || (size_t)from > ss.getSlides().size() || (size_t)to > ss.getSlides().size()) {
@@ -343,30 +442,32 @@ void CommandMoveSlide::execute() {
     Slide tmp = ss.getSlides()[(size_t)from - 1];
     ss.getSlides().erase(ss.getSlides().begin() + (from - 1));
     ss.getSlides().insert(ss.getSlides().begin() + (to - 1), tmp);
+    session.notifySlides({SlideEdit::Kind::Move, (size_t)from - 1, (size_t)to - 1});
 
     success() << "Moved slide " << from << " -> " << to << "\n";
 }
 
-CommandGotoSlide::CommandGotoSlide(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
+CommandGotoSlide::CommandGotoSlide(Session& c, const std::vector<std::string>& a)
+    : session(c) {
+    if (a.empty()) argError = "Usage: goto <slideIndex>";
+    else if (!parseInt(a[0], idx)) argError = "Invalid slide index.";
+}
 
 void CommandGotoSlide::execute() {
-    if (ctrl.getSlideshows().empty()) {
+    if (session.getSlideshows().empty()) {
         error() << "No presentation loaded.\n";
         return;
     }
-    SlideShow& ss = ctrl.getCurrentSlideshow();
+    SlideShow& ss = session.getCurrentSlideshow();
     if (ss.getSlides().empty()) {
         error() << "No slides.\n";
         return;
     }
-    if (args.empty()) {
-        error() << "Usage: goto <slideIndex>\n";
+    if (!argError.empty()) {
+        error() << argError << "\n";
         return;
     }
-
-    int idx = 0;
-    if (!parseInt(args[0], idx) || idx < 1 || (size_t)idx > ss.getSlides().size()) {
+    if (idx < 1 || (size_t)idx > ss.getSlides().size()) {
         error() << "Invalid slide index.\n";
         return;
     }
@@ -374,33 +475,45 @@ void CommandGotoSlide::execute() {
     info() << "Current slide: " << idx << "\n";
 }
 
-CommandNext::CommandNext(SlideShow& s) : ss(s) {}
+CommandNext::CommandNext(Session& c) : session(c) {}
 void CommandNext::execute() {
+    if (session.getSlideshows().empty()) return;
+    SlideShow& ss = session.getCurrentSlideshow();
     if (ss.getSlides().empty()) return;
     size_t i = ss.getCurrentIndex();
     if (i + 1 < ss.getSlides().size()) ss.setCurrentIndex(i + 1);
 }
 
-CommandPrev::CommandPrev(SlideShow& s) : ss(s) {}
+CommandPrev::CommandPrev(Session& c) : session(c) {}
 void CommandPrev::execute() {
+    if (session.getSlideshows().empty()) return;
+    SlideShow& ss = session.getCurrentSlideshow();
     if (ss.getSlides().empty()) return;
     size_t i = ss.getCurrentIndex();
     if (i > 0) ss.setCurrentIndex(i - 1);
 }
 
-CommandShow::CommandShow(SlideShow& s) : ss(s) {}
+CommandShow::CommandShow(Session& c) : session(c) {}
 void CommandShow::execute() {
-    std::cout << "Slides: " << ss.getSlides().size()
+    if (session.getSlideshows().empty()) return;
+    const SlideShow& ss = session.getCurrentSlideshow();
+    if (const OutputFormat fmt = outputFormat(); fmt != OutputFormat::Text) {
+        RecordWriter w(fmt, "slideshow", {"name", "slides", "current"});
+        w.field(ss.getFilename()).field(static_cast<int64_t>(ss.getSlides().size()))
+         .field(static_cast<int64_t>(ss.getCurrentIndex() + 1)).end();
+        return;
+    }
+    out() << "Slides: " << ss.getSlides().size()
               << ", current=" << (ss.getCurrentIndex() + 1) << "\n";
 }
 
-CommandPreview::CommandPreview(Controller& c) : ctrl(c) {}
+CommandPreview::CommandPreview(Session& c) : session(c) {}
 void CommandPreview::execute() {
-    if (ctrl.getSlideshows().empty()) {
+    if (session.getSlideshows().empty()) {
         error() << "No presentation loaded.\n";
         return;
     }
-    SlideShow& ss = ctrl.getCurrentSlideshow();
+    SlideShow& ss = session.getCurrentSlideshow();
     if (ss.getSlides().empty()) {
         error() << "No slides.\n";
         return;
@@ -409,44 +522,51 @@ void CommandPreview::execute() {
     const Slide& s = ss.getSlides()[ss.getCurrentIndex()];
     const auto& shapes = s.getShapes();
 
-    std::cout << "Preview (text-only)\n";
-    std::cout << "  Slide: " << (ss.getCurrentIndex() + 1) << " / " << ss.getSlides().size() << "\n";
-    std::cout << "  Shapes: " << shapes.size() << "\n";
+    if (const OutputFormat fmt = outputFormat(); fmt != OutputFormat::Text) {
+        writeShapeRecords(fmt, ss.getCurrentIndex() + 1, shapes);
+        return;
+    }
+
+    out() << "Preview (text-only)\n"
+          << "  Slide: " << (ss.getCurrentIndex() + 1) << " / " << ss.getSlides().size() << "\n"
+          << "  Shapes: " << shapes.size() << "\n";
     for (size_t i = 0; i < shapes.size(); ++i) {
         const Shape& sh = shapes[i];
-        std::cout << "    #" << i << " kind=";
-        if (sh.kind() == ShapeKind::Text) std::cout << "Text";
-        else if (sh.kind() == ShapeKind::Image) std::cout << "Image";
-        else if (sh.kind() == ShapeKind::Rect) std::cout << "Rect";
-        else std::cout << "Ellipse";
-        std::cout << " x=" << sh.getX() << " y=" << sh.getY()
-                  << " w=" << sh.getW() << " h=" << sh.getH();
+        auto line = out();
+        line << "    #" << i << " kind=" << shapeKindName(sh.kind())
+             << " x=" << sh.getX() << " y=" << sh.getY()
+             << " w=" << sh.getW() << " h=" << sh.getH();
         if (sh.kind() != ShapeKind::Image) {
-            std::cout << " text=\"" << sh.getText() << "\"";
+            line << " text=\"" << sh.getText() << "\"";
         }
-        std::cout << "\n";
+        line << "\n";
     }
 
     info() << "Tip: Use SlideShowGUI for real preview.\n";
 }
 
-CommandUndo::CommandUndo(Controller& c) : ctrl(c) {}
-void CommandUndo::execute() { ctrl.undo(); }
+CommandUndo::CommandUndo(Session& c) : session(c) {}
+void CommandUndo::execute() { session.undo(); }
 
-CommandRedo::CommandRedo(Controller& c) : ctrl(c) {}
-void CommandRedo::execute() { ctrl.redo(); }
+CommandRedo::CommandRedo(Session& c) : session(c) {}
+void CommandRedo::execute() { session.redo(); }
 
 // -------------------------
 // Shape commands
 // -------------------------
 
-CommandListShapes::CommandListShapes(Controller& c) : ctrl(c) {}
+CommandListShapes::CommandListShapes(Session& c) : session(c) {}
 void CommandListShapes::execute() {
     SlideShow* ss = nullptr;
     Slide* slide = nullptr;
-    if (!ensureCurrentSlide(ctrl, ss, slide)) return;
+    if (!ensureCurrentSlide(session, ss, slide, false)) return;
 
     const auto& shapes = slide->getShapes();
+    if (const OutputFormat fmt = outputFormat(); fmt != OutputFormat::Text) {
+        writeShapeRecords(fmt, ss->getCurrentIndex() + 1, shapes);
+        return;
+    }
+
     info() << "Shapes on slide " << (ss->getCurrentIndex() + 1) << ":\n";
 
     if (shapes.empty()) {
@@ -456,183 +576,163 @@ void CommandListShapes::execute() {
 
     for (size_t i = 0; i < shapes.size(); ++i) {
         const Shape& sh = shapes[i];
-        std::string kind =
-            (sh.kind() == ShapeKind::Text) ? "Text" :
-            (sh.kind() == ShapeKind::Image) ? "Image" :
-            (sh.kind() == ShapeKind::Rect) ? "Rect" : "Ellipse";
-
-        std::cout << "  [" << (i + 1) << "] " << kind
-                  << "  x=" << sh.getX() << " y=" << sh.getY()
-                  << "  w=" << sh.getW() << " h=" << sh.getH();
-
-        if (sh.isImage()) std::cout << "  bytes=" << sh.getImageData().size();
-        if (!sh.getText().empty()) std::cout << "  text=\"" << sh.getText() << "\"";
-        std::cout << "\n";
+        auto line = out();
+        line << "  [" << (i + 1) << "] " << shapeKindName(sh.kind())
+             << "  x=" << sh.getX() << " y=" << sh.getY()
+             << "  w=" << sh.getW() << " h=" << sh.getH();
+
+        if (sh.isImage()) line << "  bytes=" << sh.getImageData().size();
+        if (!sh.getText().empty()) line << "  text=\"" << sh.getText() << "\"";
+        line << "\n";
     }
 }
 
-CommandAddShape::CommandAddShape(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
-
-void CommandAddShape::execute() {
-    SlideShow* ss = nullptr;
-    Slide* slide = nullptr;
-    if (!ensureCurrentSlide(ctrl, ss, slide)) return;
-
-    if (args.empty()) {
-        error() << "Usage: add rect|ellipse|text|image ...\n";
+CommandAddShape::CommandAddShape(Session& c, const std::vector<std::string>& a)
+    : session(c) {
+    if (a.empty()) {
+        argError = "Usage: add rect|ellipse|text|image ...";
         return;
     }
 
-    std::string kind = toLower(args[0]);
+    const std::string k = toLower(a[0]);
 
-    // add rect x y w h [text...]
-    if (kind == "rect" || kind == "rectangle") {
-        if (args.size() < 5) {
-            error() << "Usage: add rect <x> <y> <w> <h> [text...]\n";
+    // add rect|ellipse x y w h [text...]
+    if (k == "rect" || k == "rectangle" || k == "ellipse" || k == "oval") {
+        kind = (k == "rect" || k == "rectangle") ? ShapeKind::Rect : ShapeKind::Ellipse;
+        if (a.size() < 5) {
+            argError = kind == ShapeKind::Rect ? "Usage: add rect <x> <y> <w> <h> [text...]"
+                                               : "Usage: add ellipse <x> <y> <w> <h> [text...]";
             return;
         }
-        int x=0,y=0,w=0,h=0;
-        if (!parseInt(args[1],x) || !parseInt(args[2],y) || !parseInt(args[3],w) || !parseInt(args[4],h)) {
-            error() << "Invalid numbers.\n";
+        if (!parseInt(a[1],x) || !parseInt(a[2],y) || !parseInt(a[3],w) || !parseInt(a[4],h)) {
+            argError = "Invalid numbers.";
             return;
         }
         if (w < 1) w = 1;
         if (h < 1) h = 1;
-        std::string text = (args.size() > 5) ? joinFrom(args, 5) : "Text";
-
-        Shape sh("Rectangle", x, y, ShapeKind::Rect, w, h);
-        sh.setText(text);
-        slide->addShape(std::move(sh));
-        success() << "Added rectangle.\n";
-        return;
-    }
-
-    // add ellipse x y w h [text...]
-    if (kind == "ellipse" || kind == "oval") {
-        if (args.size() < 5) {
-            error() << "Usage: add ellipse <x> <y> <w> <h> [text...]\n";
-            return;
-        }
-        int x=0,y=0,w=0,h=0;
-        if (!parseInt(args[1],x) || !parseInt(args[2],y) || !parseInt(args[3],w) || !parseInt(args[4],h)) {
-            error() << "Invalid numbers.\n";
-            return;
-        }
-        if (w < 1) w = 1;
-        if (h < 1) h = 1;
-        std::string text = (args.size() > 5) ? joinFrom(args, 5) : "Text";
-
-        Shape sh("Ellipse", x, y, ShapeKind::Ellipse, w, h);
-        sh.setText(text);
-        slide->addShape(std::move(sh));
-        success() << "Added ellipse.\n";
+        text = (a.size() > 5) ? joinFrom(a, 5) : "Text";
         return;
     }
 
     // add text x y [text...]
-    if (kind == "text") {
-        if (args.size() < 3) {
-            error() << "Usage: add text <x> <y> [text...]\n";
+    if (k == "text") {
+        kind = ShapeKind::Text;
+        if (a.size() < 3) {
+            argError = "Usage: add text <x> <y> [text...]";
             return;
         }
-        int x=0,y=0;
-        if (!parseInt(args[1],x) || !parseInt(args[2],y)) {
-            error() << "Invalid numbers.\n";
+        if (!parseInt(a[1],x) || !parseInt(a[2],y)) {
+            argError = "Invalid numbers.";
             return;
         }
-        std::string text = (args.size() > 3) ? joinFrom(args, 3) : "Text";
-        Shape sh(text, x, y);
-        sh.setText(text);
-        slide->addShape(std::move(sh));
-        success() << "Added text.\n";
+        text = (a.size() > 3) ? joinFrom(a, 3) : "Text";
         return;
     }
 
     // add image x y path [w h]
-    if (kind == "image" || kind == "img") {
-        if (args.size() < 4) {
-            error() << "Usage: add image <x> <y> <path> [w h]\n";
+    if (k == "image" || k == "img") {
+        kind = ShapeKind::Image;
+        if (a.size() < 4) {
+            argError = "Usage: add image <x> <y> <path> [w h]";
             return;
         }
-        int x=0,y=0;
-        if (!parseInt(args[1],x) || !parseInt(args[2],y)) {
-            error() << "Invalid numbers.\n";
+        if (!parseInt(a[1],x) || !parseInt(a[2],y)) {
+            argError = "Invalid numbers.";
             return;
         }
-
-        const std::string path = args[3];
-
-        int w = 1, h = 1;
-        if (args.size() >= 6) {
+        path = a[3];
+        if (a.size() >= 6) {
             int tw=0, th=0;
-            if (parseInt(args[4], tw) && parseInt(args[5], th) && tw > 0 && th > 0) {
+            if (parseInt(a[4], tw) && parseInt(a[5], th) && tw > 0 && th > 0) {
                 w = tw; h = th;
             }
         }
+        return;
+    }
 
-        std::vector<uint8_t> pngBytes;
-        int imgW = 0, imgH = 0;
-        if (!loadAnyImageAsPngBytes(path, pngBytes, imgW, imgH)) return;
+    argError = "Unknown shape kind: " + k;
+}
 
-        Shape sh("Image", x, y, std::move(pngBytes));
-        if (w > 1 && h > 1) { sh.setW(w); sh.setH(h); } // otherwise PPTXSerializer uses PNG size
+void CommandAddShape::execute() {
+    SlideShow* ss = nullptr;
+    Slide* slide = nullptr;
+    if (!ensureCurrentSlide(session, ss, slide)) return;
+
+    if (!argError.empty()) {
+        error() << argError << "\n";
+        return;
+    }
+
+    if (kind == ShapeKind::Rect || kind == ShapeKind::Ellipse) {
+        const bool rect = kind == ShapeKind::Rect;
+        Shape sh(rect ? "Rectangle" : "Ellipse", x, y, kind, w, h);
+        sh.setText(text);
+        session.getTextIndex().add(sh);
         slide->addShape(std::move(sh));
+        success() << "Added " << (rect ? "rectangle" : "ellipse") << ".\n";
+        return;
+    }
 
-        success() << "Added image.\n";
+    if (kind == ShapeKind::Text) {
+        Shape sh(text, x, y);
+        sh.setText(text);
+        session.getTextIndex().add(sh);
+        slide->addShape(std::move(sh));
+        success() << "Added text.\n";
         return;
     }
 
-    error() << "Unknown shape kind: " << kind << "\n";
-}
+    // The file is read on every run: it may change between replays.
+    std::vector<uint8_t> pngBytes;
+    int imgW = 0, imgH = 0;
+    if (!loadAnyImageAsPngBytes(path, pngBytes, imgW, imgH)) return;
 
-CommandRemoveShape::CommandRemoveShape(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
+    Shape sh("Image", x, y, std::move(pngBytes));
+    if (w > 1 && h > 1) { sh.setW(w); sh.setH(h); } // otherwise PPTXSerializer uses PNG size
+    session.getTextIndex().add(sh);
+    slide->addShape(std::move(sh));
 
-void CommandRemoveShape::execute() {
-    SlideShow* ss = nullptr;
-    Slide* slide = nullptr;
-    if (!ensureCurrentSlide(ctrl, ss, slide)) return;
+    success() << "Added image.\n";
+}
 
+CommandRemoveShape::CommandRemoveShape(Session& c, const std::vector<std::string>& a)
+    : session(c) {
     // accepts: ["shape","2"] or ["2"]
     size_t pos = 0;
-    if (!args.empty() && toLower(args[0]) == "shape") pos = 1;
-    if (args.size() <= pos) {
-        error() << "Usage: remove shape <idx>\n";
-        return;
-    }
+    if (!a.empty() && toLower(a[0]) == "shape") pos = 1;
+    if (a.size() <= pos) argError = "Usage: remove shape <idx>";
+    else if (!parseInt(a[pos], idx)) argError = "Invalid idx.";
+}
 
-    int idx = 0;
-    if (!parseInt(args[pos], idx)) { error() << "Invalid idx.\n"; return; }
+void CommandRemoveShape::execute() {
+    SlideShow* ss = nullptr;
+    Slide* slide = nullptr;
+    if (!ensureCurrentSlide(session, ss, slide)) return;
+    if (!argError.empty()) { error() << argError << "\n"; return; }
 
     auto& shapes = slide->getShapes();
     if (idx < 1 || (size_t)idx > shapes.size()) { error() << "Index out of range.\n"; return; }
 
+    session.getTextIndex().remove(shapes[(size_t)idx - 1].getId());
     shapes.erase(shapes.begin() + (idx - 1));
     success() << "Removed shape " << idx << "\n";
 }
 
-CommandMoveShape::CommandMoveShape(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
+CommandMoveShape::CommandMoveShape(Session& c, const std::vector<std::string>& a)
+    : session(c) {
+    // move shape <idx> <x> <y>
+    size_t pos = 0;
+    if (!a.empty() && toLower(a[0]) == "shape") pos = 1;
+    if (a.size() < pos + 3) argError = "Usage: move shape <idx> <x> <y>";
+    else if (!parseInt(a[pos], idx) || !parseInt(a[pos+1], x) || !parseInt(a[pos+2], y))
+        argError = "Invalid numbers.";
+}
 
 void CommandMoveShape::execute() {
     SlideShow* ss = nullptr;
     Slide* slide = nullptr;
-    if (!ensureCurrentSlide(ctrl, ss, slide)) return;
-
-    // move shape <idx> <x> <y>
-    size_t pos = 0;
-    if (!args.empty() && toLower(args[0]) == "shape") pos = 1;
-    if (args.size() < pos + 3) {
-        error() << "Usage: move shape <idx> <x> <y>\n";
-        return;
-    }
-
-    int idx=0,x=0,y=0;
-    if (!parseInt(args[pos], idx) || !parseInt(args[pos+1], x) || !parseInt(args[pos+2], y)) {
-        error() << "Invalid numbers.\n";
-        return;
-    }
+    if (!ensureCurrentSlide(session, ss, slide)) return;
+    if (!argError.empty()) { error() << argError << "\n"; return; }
 
     auto& shapes = slide->getShapes();
     if (idx < 1 || (size_t)idx > shapes.size()) { error() << "Index out of range.\n"; return; }
@@ -643,29 +743,28 @@ void CommandMoveShape::execute() {
     success() << "Moved shape " << idx << " to (" << x << "," << y << ")\n";
 }
 
-CommandResizeShape::CommandResizeShape(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
-
-void CommandResizeShape::execute() {
-    SlideShow* ss = nullptr;
-    Slide* slide = nullptr;
-    if (!ensureCurrentSlide(ctrl, ss, slide)) return;
-
+CommandResizeShape::CommandResizeShape(Session& c, const std::vector<std::string>& a)
+    : session(c) {
     // resize shape <idx> <w> <h>
     size_t pos = 0;
-    if (!args.empty() && toLower(args[0]) == "shape") pos = 1;
-    if (args.size() < pos + 3) {
-        error() << "Usage: resize shape <idx> <w> <h>\n";
+    if (!a.empty() && toLower(a[0]) == "shape") pos = 1;
+    if (a.size() < pos + 3) {
+        argError = "Usage: resize shape <idx> <w> <h>";
         return;
     }
-
-    int idx=0,w=0,h=0;
-    if (!parseInt(args[pos], idx) || !parseInt(args[pos+1], w) || !parseInt(args[pos+2], h)) {
-        error() << "Invalid numbers.\n";
+    if (!parseInt(a[pos], idx) || !parseInt(a[pos+1], w) || !parseInt(a[pos+2], h)) {
+        argError = "Invalid numbers.";
         return;
     }
     if (w < 1) w = 1;
     if (h < 1) h = 1;
+}
+
+void CommandResizeShape::execute() {
+    SlideShow* ss = nullptr;
+    Slide* slide = nullptr;
+    if (!ensureCurrentSlide(session, ss, slide)) return;
+    if (!argError.empty()) { error() << argError << "\n"; return; }
 
     auto& shapes = slide->getShapes();
     if (idx < 1 || (size_t)idx > shapes.size()) { error() << "Index out of range.\n"; return; }
@@ -676,67 +775,393 @@ void CommandResizeShape::execute() {
     success() << "Resized shape " << idx << " to (" << w << "x" << h << ")\n";
 }
 
-CommandSetShapeText::CommandSetShapeText(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
-
-void CommandSetShapeText::execute() {
-    SlideShow* ss = nullptr;
-    Slide* slide = nullptr;
-    if (!ensureCurrentSlide(ctrl, ss, slide)) return;
-
+CommandSetShapeText::CommandSetShapeText(Session& c, const std::vector<std::string>& a)
+    : session(c) {
     // text shape <idx> [text...]
     size_t pos = 0;
-    if (!args.empty() && toLower(args[0]) == "shape") pos = 1;
-    if (args.size() < pos + 1) {
-        error() << "Usage: text shape <idx> [text...]\n";
+    if (!a.empty() && toLower(a[0]) == "shape") pos = 1;
+    if (a.size() < pos + 1) {
+        argError = "Usage: text shape <idx> [text...]";
+        return;
+    }
+    if (!parseInt(a[pos], idx)) {
+        argError = "Invalid idx.";
         return;
     }
+    text = (a.size() > pos + 1) ? joinFrom(a, pos + 1) : "";
+}
 
-    int idx=0;
-    if (!parseInt(args[pos], idx)) { error() << "Invalid idx.\n"; return; }
+void CommandSetShapeText::execute() {
+    SlideShow* ss = nullptr;
+    Slide* slide = nullptr;
+    if (!ensureCurrentSlide(session, ss, slide)) return;
+    if (!argError.empty()) { error() << argError << "\n"; return; }
 
     auto& shapes = slide->getShapes();
     if (idx < 1 || (size_t)idx > shapes.size()) { error() << "Index out of range.\n"; return; }
 
-    std::string text = (args.size() > pos + 1) ? joinFrom(args, pos + 1) : "";
     shapes[(size_t)idx - 1].setText(text);
+    session.getTextIndex().update(shapes[(size_t)idx - 1]);
     success() << "Set text for shape " << idx << "\n";
 }
 
-CommandDuplicateShape::CommandDuplicateShape(Controller& c, const std::vector<std::string>& a)
-    : ctrl(c), args(a) {}
-
-void CommandDuplicateShape::execute() {
-    SlideShow* ss = nullptr;
-    Slide* slide = nullptr;
-    if (!ensureCurrentSlide(ctrl, ss, slide)) return;
-
+CommandDuplicateShape::CommandDuplicateShape(Session& c, const std::vector<std::string>& a)
+    : session(c) {
     // duplicate shape <idx> [dx dy]
     size_t pos = 0;
-    if (!args.empty() && toLower(args[0]) == "shape") pos = 1;
-    if (args.size() < pos + 1) {
-        error() << "Usage: duplicate shape <idx> [dx dy]\n";
+    if (!a.empty() && toLower(a[0]) == "shape") pos = 1;
+    if (a.size() < pos + 1) {
+        argError = "Usage: duplicate shape <idx> [dx dy]";
         return;
     }
-
-    int idx=0;
-    if (!parseInt(args[pos], idx)) { error() << "Invalid idx.\n"; return; }
-
-    int dx = 20, dy = 20;
-    if (args.size() >= pos + 3) {
+    if (!parseInt(a[pos], idx)) {
+        argError = "Invalid idx.";
+        return;
+    }
+    if (a.size() >= pos + 3) {
         int tdx=0, tdy=0;
-        if (parseInt(args[pos+1], tdx) && parseInt(args[pos+2], tdy)) {
+        if (parseInt(a[pos+1], tdx) && parseInt(a[pos+2], tdy)) {
             dx = tdx; dy = tdy;
         }
     }
+}
+
+void CommandDuplicateShape::execute() {
+    SlideShow* ss = nullptr;
+    Slide* slide = nullptr;
+    if (!ensureCurrentSlide(session, ss, slide)) return;
+    if (!argError.empty()) { error() << argError << "\n"; return; }
 
     auto& shapes = slide->getShapes();
     if (idx < 1 || (size_t)idx > shapes.size()) { error() << "Index out of range.\n"; return; }
 
     Shape copy = shapes[(size_t)idx - 1];
+    copy.assignNewId();
     copy.setX(copy.getX() + dx);
     copy.setY(copy.getY() + dy);
+    session.getTextIndex().add(copy);
     slide->addShape(std::move(copy));
 
     success() << "Duplicated shape " << idx << "\n";
 }
+
+// -------------------------
+// Macros
+// -------------------------
+
+CommandRecordMacro::CommandRecordMacro(Session& c, const std::vector<std::string>& a)
+    : session(c), args(a) {}
+
+void CommandRecordMacro::execute() {
+    if (args.empty()) {
+        error() << "Usage: record <name>\n";
+        return;
+    }
+    if (session.isRecording()) {
+        error() << "Already recording '" << session.getRecordingName() << "'. Use 'stop' first.\n";
+        return;
+    }
+    session.startRecording(args[0]);
+    info() << "Recording macro '" << args[0] << "'. Use 'stop' to finish.\n";
+}
+
+CommandStopRecording::CommandStopRecording(Session& c) : session(c) {}
+
+void CommandStopRecording::execute() {
+    if (!session.isRecording()) {
+        error() << "Not recording.\n";
+        return;
+    }
+    const std::string name = session.getRecordingName();
+
+    // Compile: parse every line once, bound to this session, arguments
+    // included. Recording is already off, so these parse() calls are not
+    // captured again.
+    Macro m;
+    m.source = session.stopRecording();
+    m.steps.reserve(m.source.size());
+    for (size_t i = 0; i < m.source.size(); ++i) {
+        std::istringstream in(m.source[i]);
+        std::unique_ptr<ICommand> step = CommandParser::parse(in, session);
+        if (!step) {
+            error() << "Macro '" << name << "' discarded: step " << (i + 1)
+                    << " does not compile: " << m.source[i] << "\n";
+            return;
+        }
+        if (const std::string why = step->argumentError(); !why.empty()) {
+            error() << "Macro '" << name << "' discarded: step " << (i + 1)
+                    << " (" << m.source[i] << "): " << why << "\n";
+            return;
+        }
+        m.steps.push_back(std::move(step));
+    }
+
+    const size_t n = m.steps.size();
+    session.setMacro(name, std::move(m));
+    success() << "Recorded macro '" << name << "' (" << n << " steps)\n";
+}
+
+CommandPlayMacro::CommandPlayMacro(Session& c, const std::vector<std::string>& a)
+    : session(c), args(a) {}
+
+void CommandPlayMacro::execute() {
+    if (args.empty()) {
+        error() << "Usage: play <name> [times]\n";
+        return;
+    }
+    Macro* m = session.findMacro(args[0]);
+    if (!m) {
+        error() << "No macro named '" << args[0] << "'\n";
+        return;
+    }
+
+    int times = 1;
+    if (args.size() >= 2 && (!parseInt(args[1], times) || times < 1)) {
+        error() << "Invalid repeat count.\n";
+        return;
+    }
+
+    for (int t = 0; t < times; ++t) {
+        for (auto& step : m->steps) {
+            step->execute();
+            session.rebuildUiIndex();
+        }
+    }
+    success() << "Played macro '" << args[0] << "' x" << times << "\n";
+}
+
+CommandFindShapes::CommandFindShapes(Session& c, const std::vector<std::string>& a)
+    : session(c) {
+    // find shapes where text~<needle> [in all slides | in all presentations]
+    // The tokenizer splits `text~"Q3"` into "text~" and "Q3"; `text~Q3` stays one token.
+    const char* usage = "Usage: find shapes where text~\"...\" [in all slides|in all presentations]";
+
+    size_t pos = 0;
+    if (pos < a.size() && toLower(a[pos]) == "shapes") ++pos;
+    if (pos < a.size() && toLower(a[pos]) == "where") ++pos;
+    if (pos >= a.size() || toLower(a[pos]).rfind("text~", 0) != 0) {
+        argError = usage;
+        return;
+    }
+
+    needle = a[pos].substr(5);
+    ++pos;
+    if (needle.empty()) {
+        if (pos >= a.size()) { argError = usage; return; }
+        needle = a[pos++];
+    }
+
+    const std::string rest = toLower(joinFrom(a, pos));
+    if (rest == "in all slides" || rest == "all slides") scope = Scope::Slides;
+    else if (rest == "in all presentations" || rest == "all presentations") scope = Scope::Presentations;
+    else if (!rest.empty()) argError = usage;
+}
+
+void CommandFindShapes::execute() {
+    if (!argError.empty()) {
+        error() << argError << "\n";
+        return;
+    }
+
+    if (session.getSlideshows().empty()) {
+        error() << "No presentation loaded.\n";
+        return;
+    }
+
+    const std::vector<ShapeTextIndex::Hit> hits = session.findText(needle);
+    const std::string folded = toLower(needle);
+
+    // Hits come with their positions, in document order; only the scope is
+    // checked here. The live text is re-checked so a stale index entry can
+    // never produce a false hit.
+    auto& slideshows = session.getSlideshows();
+    const size_t curPres = session.getCurrentIndex();
+    size_t found = 0;
+
+    for (const auto& hit : hits) {
+        const size_t p = hit.where.presentation;
+        const size_t s = hit.where.slide;
+        const size_t k = hit.where.shape;
+        if (scope != Scope::Presentations && p != curPres) continue;
+        if (scope == Scope::Slide && s != slideshows[p].getCurrentIndex()) continue;
+        const Shape& sh = slideshows[p].getSlides()[s].getShapes()[k];
+        if (toLower(sh.getText()).find(folded) == std::string::npos) continue;
+
+        if (found++ == 0) info() << "Matches for \"" << needle << "\":\n";
+        auto line = out();
+        line << "  ";
+        if (scope == Scope::Presentations) line << "presentation " << (p + 1) << " ";
+        line << "slide " << (s + 1) << " shape " << (k + 1)
+             << "  text=\"" << sh.getText() << "\"\n";
+    }
+
+    if (found == 0) info() << "No shapes match \"" << needle << "\"\n";
+    else info() << found << " match(es)\n";
+}
+
+CommandStats::CommandStats(const std::vector<std::string>& a) : args(a) {}
+
+void CommandStats::execute() {
+    if (!args.empty()) {
+        if (toLower(args[0]) != "reset") {
+            error() << "Usage: stats [reset]\n";
+            return;
+        }
+        prof::reset();
+        success() << "Timing statistics cleared\n";
+        return;
+    }
+    if (prof::collect().empty()) {
+        info() << "No timings recorded yet\n";
+        return;
+    }
+    info() << "Timings since start (or last 'stats reset'):\n";
+    prof::report(out().stream());
+}
+
+CommandTrace::CommandTrace(const std::vector<std::string>& a) : args(a) {}
+
+void CommandTrace::execute() {
+    const std::string sub = args.empty() ? std::string() : toLower(args[0]);
+    std::string err;
+
+    if (sub == "start" && args.size() == 2) {
+        if (!prof::startTrace(args[1], &err)) {
+            error() << "Cannot start trace: " << err << "\n";
+            return;
+        }
+        success() << "Tracing to " << args[1] << " (use 'trace stop' to write it)\n";
+        return;
+    }
+    if (sub == "stop" && args.size() == 1) {
+        const std::string path = prof::tracePath();
+        size_t events = 0, dropped = 0;
+        if (!prof::stopTrace(&events, &dropped, &err)) {
+            error() << "Cannot stop trace: " << err << "\n";
+            return;
+        }
+        success() << "Wrote " << events << " events to " << path << "\n";
+        if (dropped) info() << dropped << " events dropped (per-thread limit)\n";
+        return;
+    }
+    if (sub.empty()) {
+        const std::string path = prof::tracePath();
+        if (path.empty()) info() << "Not tracing\n";
+        else info() << "Tracing to " << path << "\n";
+        return;
+    }
+    error() << "Usage: trace start <file.json> | trace stop\n";
+}
+
+CommandMem::CommandMem(Session& c, const std::vector<std::string>& a)
+    : session(c), args(a) {}
+
+void CommandMem::execute() {
+    int top = 5;
+    for (const auto& a : args) {
+        const std::string low = toLower(a);
+        if (low.rfind("top=", 0) != 0 || !parseInt(low.substr(4), top) || top < 0) {
+            error() << "Usage: mem [top=N]\n";
+            return;
+        }
+    }
+
+    const mem::Report r = mem::measure(session, static_cast<size_t>(top));
+    const auto& shows = session.getSlideshows();
+
+    info() << "Memory (estimated, allocator overhead excluded):\n";
+    if (r.presentations.empty()) {
+        out() << "  no open presentations\n";
+    }
+    for (const auto& p : r.presentations) {
+        out() << "  " << std::left << std::setw(24) << p.name << std::right
+              << std::setw(5) << p.slides << " slides" << std::setw(7) << p.shapes << " shapes  "
+              << std::setw(10) << mem::formatBytes(p.bytes)
+              << "  (images " << mem::formatBytes(p.imageBytes)
+              << ", strings " << mem::formatBytes(p.stringBytes) << ")\n";
+    }
+    out() << "  total " << mem::formatBytes(r.totalBytes) << "\n";
+
+    out() << "Images: " << r.images << " (" << mem::formatBytes(r.imageBytes) << "), "
+          << r.uniqueImages << " unique (" << mem::formatBytes(r.uniqueImageBytes) << "), "
+          << "duplicated " << mem::formatBytes(r.imageBytes - r.uniqueImageBytes) << "\n";
+    out() << "Strings: " << mem::formatBytes(r.stringBytes) << " on the heap\n";
+
+    if (!r.largestSlides.empty()) {
+        out() << "Largest slides:\n";
+        for (const auto& s : r.largestSlides) {
+            out() << "  " << shows[s.presentation].getFilename() << " slide " << (s.slide + 1)
+                  << ": " << mem::formatBytes(s.bytes) << "\n";
+        }
+    }
+
+    out() << "Undo: " << r.undoStates << " states, " << mem::formatBytes(r.undoBytes)
+          << " (images " << mem::formatBytes(r.undoImageBytes) << ")\n";
+    out() << "Redo: " << r.redoStates << " states, " << mem::formatBytes(r.redoBytes)
+          << " (images " << mem::formatBytes(r.redoImageBytes) << ")\n";
+}
+
+CommandGenerateDeck::CommandGenerateDeck(Session& c, const std::vector<std::string>& a)
+    : session(c), args(a) {}
+
+void CommandGenerateDeck::execute() {
+    const char* usage =
+        "Usage: generate deck <slides> <shapes> [images=N dup=P seed=S words=W imgsize=PX name=NAME]\n";
+
+    size_t pos = 0;
+    if (pos < args.size() && toLower(args[pos]) == "deck") ++pos;
+
+    int slides = 0, shapes = 0;
+    if (args.size() < pos + 2 || !parseInt(args[pos], slides) || !parseInt(args[pos + 1], shapes) ||
+        slides < 0 || shapes < 0) {
+        error() << usage;
+        return;
+    }
+
+    DeckSpec spec;
+    spec.slides = (size_t)slides;
+    spec.shapesPerSlide = (size_t)shapes;
+
+    for (size_t i = pos + 2; i < args.size(); ++i) {
+        const size_t eq = args[i].find('=');
+        if (eq == std::string::npos) { error() << usage; return; }
+        const std::string key = toLower(args[i].substr(0, eq));
+        const std::string val = args[i].substr(eq + 1);
+
+        if (key == "name") {
+            // name="My deck" tokenizes as `name=` followed by the quoted string.
+            spec.name = val;
+            if (spec.name.empty() && i + 1 < args.size()) spec.name = args[++i];
+            if (spec.name.empty()) { error() << usage; return; }
+            continue;
+        }
+        if (key == "dup") {
+            // A percentage: dup=25 or dup=12.5.
+            double pct = 0;
+            if (!parseDouble(val, pct) || !(pct >= 0 && pct <= 100)) {
+                error() << "dup must be a percentage, 0..100\n";
+                return;
+            }
+            spec.duplicateRatio = pct / 100.0;
+            continue;
+        }
+
+        int v = 0;
+        if (!parseInt(val, v) || v < 0) { error() << "Invalid value for " << key << "\n"; return; }
+        if (key == "images") spec.images = (size_t)v;
+        else if (key == "seed") spec.seed = (uint32_t)v;
+        else if (key == "words" && v > 0) spec.maxWords = (size_t)v;
+        else if (key == "imgsize" && v > 0 && v <= 4096) spec.imageSize = (unsigned)v;
+        else { error() << usage; return; }
+    }
+
+    SlideShow deck = generateDeck(spec);
+    size_t shapeCount = 0;
+    for (const auto& sl : deck.getSlides()) shapeCount += sl.getShapes().size();
+
+    session.addPresentation(std::move(deck));
+    session.getTextIndex().markStale();
+
+    success() << "Generated deck '" << spec.name << "': " << spec.slides << " slides, "
+              << shapeCount << " shapes (" << spec.images << " images)\n";
+}
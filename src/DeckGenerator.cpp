@@ -0,0 +1,85 @@
+#include "DeckGenerator.hpp"
+
+#include "Slide.hpp"
+#include "Shape.hpp"
+#include "lodepng.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+const char* const kVocab[] = {
+    "alpha", "beta", "quarterly", "revenue", "roadmap", "team", "launch",
+    "metrics", "summary", "risk", "customer", "growth", "plan", "review",
+    "budget", "timeline",
+};
+constexpr size_t kVocabSize = sizeof(kVocab) / sizeof(kVocab[0]);
+
+std::vector<uint8_t> makePng(unsigned size, uint32_t seed)
+{
+    std::vector<unsigned char> rgba(size_t(size) * size * 4);
+    for (unsigned y = 0; y < size; ++y) {
+        for (unsigned x = 0; x < size; ++x) {
+            unsigned char* p = &rgba[(size_t(y) * size + x) * 4];
+            p[0] = static_cast<unsigned char>(x + seed);
+            p[1] = static_cast<unsigned char>(y ^ (seed >> 8));
+            p[2] = static_cast<unsigned char>(x * y + seed * 7);
+            p[3] = 255;
+        }
+    }
+    std::vector<unsigned char> png;
+    if (lodepng::encode(png, rgba, size, size) != 0) return {};
+    return std::vector<uint8_t>(png.begin(), png.end());
+}
+
+} // namespace
+
+SlideShow generateDeck(const DeckSpec& spec)
+{
+    std::mt19937 rng(spec.seed);
+    std::uniform_int_distribution<int> coord(0, 800);
+    std::uniform_int_distribution<size_t> words(1, std::max<size_t>(1, spec.maxWords));
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    SlideShow ss(spec.name);
+    auto& slides = ss.getSlides();
+    slides.resize(spec.slides);
+
+    for (auto& slide : slides) {
+        slide.getShapes().reserve(spec.shapesPerSlide + spec.images / std::max<size_t>(1, spec.slides) + 1);
+        for (size_t i = 0; i < spec.shapesPerSlide; ++i) {
+            const ShapeKind kind = (i % 3 == 0) ? ShapeKind::Rect
+                                 : (i % 3 == 1) ? ShapeKind::Ellipse
+                                                : ShapeKind::Text;
+            Shape sh("Shape", coord(rng), coord(rng), kind,
+                     120 + coord(rng) / 4, 40 + coord(rng) / 8);
+
+            std::string text;
+            for (size_t n = words(rng); n > 0; --n) {
+                if (!text.empty()) text += ' ';
+                text += kVocab[rng() % kVocabSize];
+            }
+            sh.setText(text);
+            slide.addShape(std::move(sh));
+        }
+    }
+
+    if (slides.empty()) return ss;
+
+    // Distinct image payloads; duplicates pick one of them at random.
+    std::vector<std::vector<uint8_t>> distinct;
+    for (size_t i = 0; i < spec.images; ++i) {
+        const bool dup = !distinct.empty() && unit(rng) < spec.duplicateRatio;
+        if (!dup) distinct.push_back(makePng(spec.imageSize, static_cast<uint32_t>(rng())));
+        const std::vector<uint8_t>& bytes = dup ? distinct[rng() % distinct.size()] : distinct.back();
+
+        const int side = static_cast<int>(spec.imageSize);
+        Shape img("Image", coord(rng), coord(rng), bytes);
+        img.setW(side);
+        img.setH(side);
+        slides[i % slides.size()].addShape(std::move(img));
+    }
+    return ss;
+}
@@ -0,0 +1,286 @@
+#include "Json.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+
+namespace json {
+
+const Value* Value::find(const std::string& key) const
+{
+    if (type != Type::Object) return nullptr;
+    for (const auto& [k, v] : object)
+        if (k == key) return &v;
+    return nullptr;
+}
+
+namespace {
+
+class Parser
+{
+public:
+    explicit Parser(std::string_view t) : text_(t) {}
+
+    bool document(Value& out)
+    {
+        if (!value(out, 0)) return false;
+        skipWs();
+        if (pos_ != text_.size()) return fail("trailing characters");
+        return true;
+    }
+
+    const std::string& error() const { return err_; }
+
+private:
+    static constexpr int kMaxDepth = 64;
+
+    bool fail(const char* msg)
+    {
+        if (err_.empty()) err_ = std::string(msg) + " at offset " + std::to_string(pos_);
+        return false;
+    }
+
+    void skipWs()
+    {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r'))
+            ++pos_;
+    }
+
+    bool literal(std::string_view word)
+    {
+        if (text_.substr(pos_, word.size()) != word) return fail("invalid literal");
+        pos_ += word.size();
+        return true;
+    }
+
+    bool value(Value& out, int depth)
+    {
+        if (depth > kMaxDepth) return fail("nesting too deep");
+        skipWs();
+        if (pos_ >= text_.size()) return fail("unexpected end");
+
+        const char c = text_[pos_];
+        if (c == '{') return object(out, depth);
+        if (c == '[') return array(out, depth);
+        if (c == '"') { out.type = Value::Type::String; return string(out.string); }
+        if (c == 't') { out.type = Value::Type::Bool; out.boolean = true; return literal("true"); }
+        if (c == 'f') { out.type = Value::Type::Bool; out.boolean = false; return literal("false"); }
+        if (c == 'n') { out.type = Value::Type::Null; return literal("null"); }
+        return number(out);
+    }
+
+    bool number(Value& out)
+    {
+        const size_t start = pos_;
+        if (pos_ < text_.size() && (text_[pos_] == '-' || text_[pos_] == '+')) ++pos_;
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_];
+            if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+') ++pos_;
+            else break;
+        }
+        if (pos_ == start) return fail("unexpected character");
+
+        // strtod needs a terminated buffer; numbers are short.
+        const std::string tmp(text_.substr(start, pos_ - start));
+        char* end = nullptr;
+        out.number = std::strtod(tmp.c_str(), &end);
+        if (end != tmp.c_str() + tmp.size()) return fail("invalid number");
+        out.type = Value::Type::Number;
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned cp)
+    {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool hex4(unsigned& cp)
+    {
+        if (pos_ + 4 > text_.size()) return fail("bad \\u escape");
+        auto r = std::from_chars(text_.data() + pos_, text_.data() + pos_ + 4, cp, 16);
+        if (r.ptr != text_.data() + pos_ + 4) return fail("bad \\u escape");
+        pos_ += 4;
+        return true;
+    }
+
+    bool string(std::string& out)
+    {
+        ++pos_; // opening quote
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_++];
+            if (c == '"') return true;
+            if (c != '\\') { out += c; continue; }
+
+            if (pos_ >= text_.size()) break;
+            const char e = text_[pos_++];
+            switch (e) {
+            case '"':  out += '"';  break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/';  break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case 'u': {
+                unsigned cp = 0;
+                if (!hex4(cp)) return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF && text_.substr(pos_, 2) == "\\u") {
+                    pos_ += 2;
+                    unsigned lo = 0;
+                    if (!hex4(lo)) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                return fail("bad escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool array(Value& out, int depth)
+    {
+        out.type = Value::Type::Array;
+        ++pos_;
+        skipWs();
+        if (pos_ < text_.size() && text_[pos_] == ']') { ++pos_; return true; }
+
+        while (true) {
+            out.array.emplace_back();
+            if (!value(out.array.back(), depth + 1)) return false;
+            skipWs();
+            if (pos_ >= text_.size()) return fail("unterminated array");
+            if (text_[pos_] == ',') { ++pos_; continue; }
+            if (text_[pos_] == ']') { ++pos_; return true; }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool object(Value& out, int depth)
+    {
+        out.type = Value::Type::Object;
+        ++pos_;
+        skipWs();
+        if (pos_ < text_.size() && text_[pos_] == '}') { ++pos_; return true; }
+
+        while (true) {
+            skipWs();
+            if (pos_ >= text_.size() || text_[pos_] != '"') return fail("expected key");
+            std::string key;
+            if (!string(key)) return false;
+            skipWs();
+            if (pos_ >= text_.size() || text_[pos_] != ':') return fail("expected ':'");
+            ++pos_;
+
+            out.object.emplace_back(std::move(key), Value{});
+            if (!value(out.object.back().second, depth + 1)) return false;
+
+            skipWs();
+            if (pos_ >= text_.size()) return fail("unterminated object");
+            if (text_[pos_] == ',') { ++pos_; continue; }
+            if (text_[pos_] == '}') { ++pos_; return true; }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+    std::string err_;
+};
+
+} // namespace
+
+bool parse(std::string_view text, Value& out, std::string* err)
+{
+    out = Value{};
+    Parser p(text);
+    if (p.document(out)) return true;
+    if (err) *err = p.error();
+    return false;
+}
+
+void appendString(std::string& out, std::string_view s)
+{
+    static const char* hex = "0123456789abcdef";
+    out += '"';
+    size_t run = 0;  // start of the pending run of characters needing no escape
+    for (size_t i = 0; i < s.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+        }
+    }
+    out.append(s.data() + run, s.size() - run);
+    out += '"';
+}
+
+void append(std::string& out, const Value& v)
+{
+    switch (v.type) {
+    case Value::Type::Null:
+        out += "null";
+        break;
+    case Value::Type::Bool:
+        out += v.boolean ? "true" : "false";
+        break;
+    case Value::Type::Number: {
+        char buf[32];
+        auto r = std::to_chars(buf, buf + sizeof(buf), v.number);
+        out.append(buf, r.ptr);
+        break;
+    }
+    case Value::Type::String:
+        appendString(out, v.string);
+        break;
+    case Value::Type::Array:
+        out += '[';
+        for (size_t i = 0; i < v.array.size(); ++i) {
+            if (i) out += ',';
+            append(out, v.array[i]);
+        }
+        out += ']';
+        break;
+    case Value::Type::Object:
+        out += '{';
+        for (size_t i = 0; i < v.object.size(); ++i) {
+            if (i) out += ',';
+            appendString(out, v.object[i].first);
+            out += ':';
+            append(out, v.object[i].second);
+        }
+        out += '}';
+        break;
+    }
+}
+
+} // namespace json
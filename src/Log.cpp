@@ -0,0 +1,335 @@
+#include "Log.hpp"
+
+#include "Color.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace logging {
+namespace {
+
+// Appends everything to `text`; reused across records so steady-state
+// logging does not allocate.
+class StringBuf : public std::streambuf
+{
+public:
+    std::string text;
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) text.push_back(traits_type::to_char_type(ch));
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        text.append(s, static_cast<size_t>(n));
+        return n;
+    }
+};
+
+struct LineBuffer
+{
+    StringBuf buf;
+    std::ostream os{&buf};
+};
+
+// One buffer per nesting level, for a LogLine built while another is open.
+thread_local std::vector<std::unique_ptr<LineBuffer>> t_lines;
+thread_local size_t t_depth = 0;
+thread_local size_t t_errors = 0;
+
+class ConsoleSink : public Sink
+{
+public:
+    void write(Level level, std::string_view text) override
+    {
+        const char* t = tag(level);
+        if (*t) {
+            if (colorEnabled()) std::cout << colorOf(level) << t << RESET;
+            else std::cout << t;
+        }
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    void flush() override { std::cout.flush(); }
+
+private:
+    static const ColorCode& colorOf(Level level)
+    {
+        switch (level) {
+        case Level::Error: return RED;
+        case Level::Success: return CYAN;
+        default: return GREEN;
+        }
+    }
+};
+
+class FileSink : public Sink
+{
+public:
+    explicit FileSink(std::ofstream f) : file_(std::move(f)) {}
+    ~FileSink() override { FileSink::flush(); }
+
+    void write(Level level, std::string_view text) override
+    {
+        buffer_ += tag(level);
+        buffer_.append(text);
+        if (level == Level::Error || buffer_.size() >= kBufferBytes) flush();
+    }
+
+    void flush() override
+    {
+        if (buffer_.empty()) return;
+        file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        file_.flush();
+        buffer_.clear();
+    }
+
+private:
+    static constexpr size_t kBufferBytes = 64 * 1024;
+    std::ofstream file_;
+    std::string buffer_;
+};
+
+struct Record
+{
+    Level level;
+    std::string text;
+};
+
+class Logger
+{
+public:
+    static Logger& get()
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    std::atomic<int> minLevel{static_cast<int>(Level::Info)};
+
+    void write(Level level, std::string_view text)
+    {
+        bool queue = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& s : sync_) s->write(level, text);
+            queue = !async_.empty();
+        }
+        if (queue) enqueue(level, text);
+    }
+
+    void add(std::shared_ptr<Sink> sink, bool async)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!async) {
+            sync_.push_back(std::move(sink));
+            return;
+        }
+        async_.push_back(std::move(sink));
+        if (!worker_.joinable()) worker_ = std::thread([this] { drain(); });
+    }
+
+    void remove(const std::shared_ptr<Sink>& sink)
+    {
+        // Let queued records reach an async sink before it goes.
+        waitIdle();
+        std::lock_guard<std::mutex> writeLock(asyncWrite_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        sync_.erase(std::remove(sync_.begin(), sync_.end(), sink), sync_.end());
+        async_.erase(std::remove(async_.begin(), async_.end(), sink), async_.end());
+    }
+
+    void flush()
+    {
+        waitIdle();
+        std::lock_guard<std::mutex> writeLock(asyncWrite_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& s : sync_) s->flush();
+        for (const auto& s : async_) s->flush();
+    }
+
+    ~Logger()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            stop_ = true;
+        }
+        queueCv_.notify_all();
+        if (worker_.joinable()) worker_.join();
+        flush();
+    }
+
+private:
+    static constexpr size_t kMaxQueued = 65536;
+
+    Logger()
+    {
+        sync_.push_back(consoleSink());
+        Level level;
+        if (const char* env = std::getenv("SLIDESHOW_LOG_LEVEL"); env && parseLevel(env, level))
+            minLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    void enqueue(Level level, std::string_view text)
+    {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        // Producers wait rather than let a stalled sink grow the queue forever.
+        idleCv_.wait(lock, [this] { return queue_.size() < kMaxQueued || stop_; });
+        queue_.push_back({level, std::string(text)});
+        queueCv_.notify_one();
+    }
+
+    void waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        idleCv_.wait(lock, [this] { return queue_.empty() && !busy_; });
+    }
+
+    void drain()
+    {
+        std::deque<Record> batch;
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        while (true) {
+            queueCv_.wait(lock, [this] { return !queue_.empty() || stop_; });
+            if (queue_.empty()) return;
+            batch.swap(queue_);
+            busy_ = true;
+            idleCv_.notify_all();
+            lock.unlock();
+
+            {
+                std::lock_guard<std::mutex> writeLock(asyncWrite_);
+                std::vector<std::shared_ptr<Sink>> sinks;
+                {
+                    std::lock_guard<std::mutex> sinkLock(mutex_);
+                    sinks = async_;
+                }
+                for (const auto& r : batch)
+                    for (const auto& s : sinks) s->write(r.level, r.text);
+            }
+            batch.clear();
+
+            lock.lock();
+            busy_ = false;
+            idleCv_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;  // sinks; serializes synchronous writes
+    std::vector<std::shared_ptr<Sink>> sync_;
+    std::vector<std::shared_ptr<Sink>> async_;
+
+    std::mutex asyncWrite_;  // held while async sinks are written or flushed
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::condition_variable idleCv_;
+    std::deque<Record> queue_;
+    bool busy_ = false;
+    bool stop_ = false;
+    std::thread worker_;
+};
+
+} // namespace
+
+const char* tag(Level level)
+{
+    switch (level) {
+    case Level::Info: return "[INFO] ";
+    case Level::Success: return "[SUCCESS] ";
+    case Level::Error: return "[ERR] ";
+    case Level::Output: break;
+    }
+    return "";
+}
+
+bool parseLevel(const std::string& name, Level& out)
+{
+    if (name == "info") out = Level::Info;
+    else if (name == "success") out = Level::Success;
+    else if (name == "error") out = Level::Error;
+    else if (name == "quiet") out = Level::Output;
+    else return false;
+    return true;
+}
+
+std::shared_ptr<Sink> consoleSink()
+{
+    static const std::shared_ptr<Sink> sink = std::make_shared<ConsoleSink>();
+    return sink;
+}
+
+std::shared_ptr<Sink> fileSink(const std::string& path, std::string* err)
+{
+    std::ofstream f(path, std::ios::binary | std::ios::app);
+    if (!f) {
+        if (err) *err = "cannot open " + path;
+        return nullptr;
+    }
+    return std::make_shared<FileSink>(std::move(f));
+}
+
+void addSink(std::shared_ptr<Sink> sink, bool async)
+{
+    if (sink) Logger::get().add(std::move(sink), async);
+}
+
+void removeSink(const std::shared_ptr<Sink>& sink) { Logger::get().remove(sink); }
+
+void setMinLevel(Level level) { Logger::get().minLevel.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+Level minLevel() { return static_cast<Level>(Logger::get().minLevel.load(std::memory_order_relaxed)); }
+
+bool enabled(Level level)
+{
+    return level == Level::Output ||
+           static_cast<int>(level) >= Logger::get().minLevel.load(std::memory_order_relaxed);
+}
+
+void flush() { Logger::get().flush(); }
+
+size_t errorCount() { return t_errors; }
+
+LogLine::LogLine(Level level) : level_(level), os_(nullptr)
+{
+    if (level == Level::Error) ++t_errors;
+    if (!enabled(level)) return;
+
+    if (t_depth == t_lines.size()) t_lines.push_back(std::make_unique<LineBuffer>());
+    LineBuffer& line = *t_lines[t_depth++];
+    line.buf.text.clear();
+    line.os.clear();
+    line.os.flags(std::ios_base::skipws | std::ios_base::dec);
+    line.os.width(0);
+    line.os.precision(6);
+    line.os.fill(' ');
+    os_ = &line.os;
+}
+
+LogLine::~LogLine()
+{
+    if (!os_) return;
+    const std::string& text = t_lines[t_depth - 1]->buf.text;
+    if (!text.empty()) Logger::get().write(level_, text);
+    --t_depth;
+}
+
+std::ostream& LogLine::stream()
+{
+    if (os_) return *os_;
+    thread_local std::ostream discard(nullptr);
+    return discard;
+}
+
+} // namespace logging
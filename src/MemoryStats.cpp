@@ -0,0 +1,172 @@
+#include "MemoryStats.hpp"
+
+#include "Session.hpp"
+#include "SlideShow.hpp"
+#include "Slide.hpp"
+#include "Shape.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_set>
+
+namespace mem {
+namespace {
+
+// Heap bytes of a string: zero while it fits the inline buffer.
+size_t heapBytes(const std::string& s)
+{
+    const char* obj = reinterpret_cast<const char*>(&s);
+    const bool inline_ = s.data() >= obj && s.data() < obj + sizeof(s);
+    return inline_ ? 0 : s.capacity() + 1;
+}
+
+size_t stringBytesOf(const Shape& sh)
+{
+    return heapBytes(sh.getName()) + heapBytes(sh.getText());
+}
+
+// Copies of a shape share its image buffer; the report counts each buffer
+// once, where it is first seen.
+using SeenBuffers = std::unordered_set<const void*>;
+
+// Image bytes `sh` adds beyond the buffers already in `seen`.
+size_t newImageBytes(const Shape& sh, SeenBuffers& seen)
+{
+    const auto& data = sh.getImageData();
+    if (data.empty() || !seen.insert(data.data()).second) return 0;
+    return data.capacity();
+}
+
+struct Totals
+{
+    size_t bytes = 0;
+    size_t imageBytes = 0;
+};
+
+Totals totalsOf(const std::vector<SlideShow>& shows, SeenBuffers& seen)
+{
+    Totals t;
+    t.bytes = shows.capacity() * sizeof(SlideShow);
+    for (const auto& ss : shows) {
+        t.bytes += bytesOf(ss) - sizeof(SlideShow);
+        for (const auto& sl : ss.getSlides())
+            for (const auto& sh : sl.getShapes()) {
+                t.bytes -= sh.getImageData().capacity();
+                t.imageBytes += newImageBytes(sh, seen);
+            }
+    }
+    t.bytes += t.imageBytes;
+    return t;
+}
+
+struct ImageKey
+{
+    uint64_t hash;
+    size_t size;
+    bool operator==(const ImageKey& o) const { return hash == o.hash && size == o.size; }
+};
+
+struct ImageKeyHash
+{
+    size_t operator()(const ImageKey& k) const { return static_cast<size_t>(k.hash ^ (k.size * 0x9E3779B97F4A7C15ull)); }
+};
+
+} // namespace
+
+size_t bytesOf(const Shape& sh)
+{
+    return sizeof(Shape) + stringBytesOf(sh) + sh.getImageData().capacity();
+}
+
+size_t bytesOf(const Slide& slide)
+{
+    const auto& shapes = slide.getShapes();
+    size_t b = sizeof(Slide) + (shapes.capacity() - shapes.size()) * sizeof(Shape);
+    for (const auto& sh : shapes) b += bytesOf(sh);
+    return b;
+}
+
+size_t bytesOf(const SlideShow& ss)
+{
+    const auto& slides = ss.getSlides();
+    size_t b = sizeof(SlideShow) + heapBytes(ss.getFilename()) +
+               (slides.capacity() - slides.size()) * sizeof(Slide);
+    for (const auto& sl : slides) b += bytesOf(sl);
+    return b;
+}
+
+Report measure(const Session& session, size_t topSlides)
+{
+    Report r;
+    std::unordered_set<ImageKey, ImageKeyHash> seen;
+    SeenBuffers buffers;
+    std::vector<SlideUsage> slides;
+
+    const auto& shows = session.getSlideshows();
+    for (size_t p = 0; p < shows.size(); ++p) {
+        const SlideShow& ss = shows[p];
+        PresentationUsage pu;
+        pu.name = ss.getFilename();
+        pu.slides = ss.getSlides().size();
+        pu.bytes = bytesOf(ss);
+
+        for (size_t s = 0; s < ss.getSlides().size(); ++s) {
+            const Slide& sl = ss.getSlides()[s];
+            slides.push_back({p, s, bytesOf(sl)});
+            pu.shapes += sl.getShapes().size();
+
+            for (const auto& sh : sl.getShapes()) {
+                pu.stringBytes += stringBytesOf(sh);
+                if (!sh.isImage()) continue;
+                ++r.images;
+                pu.bytes -= sh.getImageData().capacity();
+                const size_t n = newImageBytes(sh, buffers);
+                if (n == 0) continue;  // shares a buffer counted already
+                pu.bytes += n;
+                pu.imageBytes += n;
+                if (seen.insert({sh.getImageHash(), sh.getImageData().size()}).second) {
+                    ++r.uniqueImages;
+                    r.uniqueImageBytes += n;
+                }
+            }
+        }
+
+        r.totalBytes += pu.bytes;
+        r.imageBytes += pu.imageBytes;
+        r.stringBytes += pu.stringBytes;
+        r.presentations.push_back(std::move(pu));
+    }
+
+    const size_t keep = std::min(topSlides, slides.size());
+    std::partial_sort(slides.begin(), slides.begin() + keep, slides.end(),
+                      [](const SlideUsage& a, const SlideUsage& b) { return a.bytes > b.bytes; });
+    slides.resize(keep);
+    r.largestSlides = std::move(slides);
+
+    session.forEachHistoryState([&](bool redo, const std::vector<SlideShow>& docs) {
+        const Totals t = totalsOf(docs, buffers);
+        if (redo) {
+            ++r.redoStates;
+            r.redoBytes += t.bytes;
+            r.redoImageBytes += t.imageBytes;
+        } else {
+            ++r.undoStates;
+            r.undoBytes += t.bytes;
+            r.undoImageBytes += t.imageBytes;
+        }
+    });
+    return r;
+}
+
+std::string formatBytes(size_t bytes)
+{
+    char buf[32];
+    if (bytes < 1024) std::snprintf(buf, sizeof(buf), "%zu B", bytes);
+    else if (bytes < 1024 * 1024) std::snprintf(buf, sizeof(buf), "%.1f KB", bytes / 1024.0);
+    else if (bytes < 1024ull * 1024 * 1024) std::snprintf(buf, sizeof(buf), "%.1f MB", bytes / (1024.0 * 1024));
+    else std::snprintf(buf, sizeof(buf), "%.2f GB", bytes / (1024.0 * 1024 * 1024));
+    return buf;
+}
+
+} // namespace mem
@@ -3,6 +3,7 @@
 #include "Slide.hpp"
 #include "Shape.hpp"
 #include "FitUtils.hpp"
+#include "Profiler.hpp"
 
 #include <zip.h>
 #include <sstream>
@@ -48,6 +49,7 @@ static void addTextPart(zip_t* zip,
                         const std::string& name,
                         const std::string& content)
 {
+    PROFILE_SCOPE(prof::Phase::SaveZipAdd);
     zip_uint64_t len = static_cast<zip_uint64_t>(content.size());
     char* buf = static_cast<char*>(std::malloc(len));
     if (!buf) return;
@@ -66,6 +68,7 @@ static void addBinaryPart(zip_t* zip,
                           const std::vector<uint8_t>& data)
 {
     if (data.empty()) return;
+    PROFILE_SCOPE(prof::Phase::SaveZipAdd);
 
     zip_uint64_t len = static_cast<zip_uint64_t>(data.size());
     uint8_t* buf = static_cast<uint8_t*>(std::malloc(len));
@@ -237,6 +240,7 @@ static bool parsePngWH(const std::vector<uint8_t>& data, int& w, int& h)
 
 static std::string zipReadFile(zip_t* z, const std::string& name)
 {
+    PROFILE_SCOPE(prof::Phase::LoadRead);
     zip_stat_t st;
     if (zip_stat(z, name.c_str(), 0, &st) != 0) return {};
     zip_file_t* f = zip_fopen(z, name.c_str(), 0);
@@ -551,10 +555,28 @@ static std::string grpSpPrXfrm(long long cx, long long cy)
 
 } // namespace
 
+#if defined(LIBZIP_VERSION_MAJOR) && (LIBZIP_VERSION_MAJOR > 1 || LIBZIP_VERSION_MINOR >= 6)
+#define SLIDESHOW_ZIP_CALLBACKS 1
+
+// zip_close() does the compression and the actual writing; map its progress
+// onto the second half of the save.
+static void zipCloseProgress(zip_t*, double f, void* ud)
+{
+    static_cast<const SerializerProgress*>(ud)->report(0.5 + 0.5 * f);
+}
+
+static int zipCloseCancel(zip_t*, void* ud)
+{
+    return static_cast<const SerializerProgress*>(ud)->cancelled() ? 1 : 0;
+}
+#endif
+
 bool PPTXSerializer::save(const std::vector<SlideShow>& slideshows,
                           const std::vector<std::string>& order,
-                          const std::string& outputFile)
+                          const std::string& outputFile,
+                          const SerializerProgress* progress)
 {
+    PROFILE_SCOPE(prof::Phase::Save);
     std::string path = outputFile;
     if (path.size() < 5 || path.substr(path.size() - 5) != ".pptx")
         path += ".pptx";
@@ -814,8 +836,18 @@ bool PPTXSerializer::save(const std::vector<SlideShow>& slideshows,
     int globalImageIndex = 1;
 
     for (int i = 0; i < totalSlides; ++i) {
+        if (progress) {
+            if (progress->cancelled()) {
+                zip_discard(zip);
+                return false;
+            }
+            progress->report(0.5 * i / totalSlides);
+        }
+
         const Slide* sl = flatSlides[i];
 
+        // Image parts are added while the XML is built, so they count here too.
+        PROFILE_TIMER(xmlTimer, prof::Phase::SaveXml);
         std::ostringstream sx;
         std::ostringstream sr;
 
@@ -943,25 +975,52 @@ const long long cxEmu = pxToEmuX(drawW, kSlideCx);
            << R"(</p:sld>)";
 
         sr << "</Relationships>";
+        xmlTimer.stop();
 
         addTextPart(zip, "ppt/slides/slide" + std::to_string(i + 1) + ".xml", sx.str());
         addTextPart(zip, "ppt/slides/_rels/slide" + std::to_string(i + 1) + ".xml.rels", sr.str());
     }
 
-    zip_close(zip);
+    if (progress) {
+#ifdef SLIDESHOW_ZIP_CALLBACKS
+        zip_register_progress_callback_with_state(zip, 0.01, zipCloseProgress, nullptr,
+                                                  const_cast<SerializerProgress*>(progress));
+        zip_register_cancel_callback_with_state(zip, zipCloseCancel, nullptr,
+                                                const_cast<SerializerProgress*>(progress));
+#endif
+        progress->report(0.5);
+    }
+
+    PROFILE_TIMER(closeTimer, prof::Phase::SaveZipClose);
+    if (zip_close(zip) != 0) {
+        zip_discard(zip);
+        return false;
+    }
+    closeTimer.stop();
+    if (progress) progress->report(1.0);
     return true;
 }
 
 bool PPTXSerializer::load(std::vector<SlideShow>& slideshows,
-                          std::map<std::string, size_t>& presentationIndex,
+                          PresentationIndex& presentationIndex,
                           std::vector<std::string>& presentationOrder,
                           size_t& currentIndex,
-                          const std::string& inputFile)
+                          const std::string& inputFile,
+                          const SerializerProgress* progress)
 {
+    PROFILE_SCOPE(prof::Phase::Load);
     int err = 0;
     zip_t* zip = zip_open(inputFile.c_str(), ZIP_RDONLY, &err);
     if (!zip) return false;
 
+    // Slide count for progress reporting (parts are numbered 1..N).
+    int slideTotal = 0;
+    if (progress) {
+        zip_stat_t st;
+        while (zip_stat(zip, ("ppt/slides/slide" + std::to_string(slideTotal + 1) + ".xml").c_str(), 0, &st) == 0)
+            ++slideTotal;
+    }
+
     slideshows.clear();
     presentationIndex.clear();
     presentationOrder.clear();
@@ -988,6 +1047,17 @@ bool PPTXSerializer::load(std::vector<SlideShow>& slideshows,
 
     int slideNum = 1;
     while (true) {
+        if (progress) {
+            if (progress->cancelled()) {
+                zip_close(zip);
+                slideshows.clear();
+                presentationIndex.clear();
+                presentationOrder.clear();
+                return false;
+            }
+            if (slideTotal > 0) progress->report(double(slideNum - 1) / slideTotal);
+        }
+
         std::string slidePath = "ppt/slides/slide" + std::to_string(slideNum) + ".xml";
 
         zip_stat_t st;
@@ -1001,6 +1071,8 @@ bool PPTXSerializer::load(std::vector<SlideShow>& slideshows,
         std::string relFile = "ppt/slides/_rels/slide" + std::to_string(slideNum) + ".xml.rels";
         std::string relXml = zipReadFile(zip, relFile);
 
+        // Includes reading the slide's images (load.media).
+        PROFILE_TIMER(parseTimer, prof::Phase::LoadParse);
         size_t pos = 0;
         while (true) {
             size_t spPos = xml.find("<p:sp>", pos);
@@ -1057,12 +1129,14 @@ bool PPTXSerializer::load(std::vector<SlideShow>& slideshows,
                 zip_stat_t ist;
                 if (zip_stat(zip, zipImgPath.c_str(), 0, &ist) != 0) { pos = endTag; continue; }
 
+                PROFILE_TIMER(mediaTimer, prof::Phase::LoadMedia);
                 zip_file_t* f = zip_fopen(zip, zipImgPath.c_str(), 0);
                 if (!f) { pos = endTag; continue; }
 
                 std::vector<uint8_t> data(ist.size);
                 zip_fread(f, data.data(), ist.size);
                 zip_fclose(f);
+                mediaTimer.stop();
 
                 int cl = 0, ct = 0, cr = 0, cb = 0;
                 extractSrcRectPct(block, cl, ct, cr, cb);
@@ -1104,10 +1178,12 @@ bool PPTXSerializer::load(std::vector<SlideShow>& slideshows,
             pos = endTag;
         }
 
+        parseTimer.stop();
         ss.getSlides().push_back(std::move(slide));
         slideNum++;
     }
 
     zip_close(zip);
+    if (progress) progress->report(1.0);
     return true;
 }
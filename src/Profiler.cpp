@@ -0,0 +1,168 @@
+#include "Profiler.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+
+namespace prof {
+namespace {
+
+// Log-linear buckets: values below 16 ns get one bucket each, above that
+// every power of two is split into 8 sub-buckets.
+constexpr int kLinear = 16;
+constexpr int kSubBits = 3;
+constexpr int kSub = 1 << kSubBits;
+constexpr int kBuckets = kLinear + (64 - 4) * kSub;
+
+int bucketOf(uint64_t v)
+{
+    if (v < uint64_t(kLinear)) return static_cast<int>(v);
+    const int e = std::bit_width(v) - 1;  // >= 4
+    const int sub = static_cast<int>((v >> (e - kSubBits)) & (kSub - 1));
+    return kLinear + (e - 4) * kSub + sub;
+}
+
+uint64_t bucketUpper(int b)
+{
+    if (b < kLinear) return static_cast<uint64_t>(b);
+    const int e = (b - kLinear) / kSub + 4;
+    const uint64_t sub = static_cast<uint64_t>((b - kLinear) % kSub);
+    const uint64_t base = uint64_t(1) << e;
+    const uint64_t step = base >> kSubBits;
+    return base + (sub + 1) * step - 1;
+}
+
+struct Histogram
+{
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint64_t> buckets[kBuckets] = {};
+};
+
+Histogram g_hist[static_cast<size_t>(Phase::Count)];
+
+const char* const kNames[] = {
+    "tokenize",
+    "parse",
+    "execute",
+    "snapshot",
+    "rebuildUiIndex",
+    "save",
+    "save.xml",
+    "save.zip_add",
+    "save.zip_close",
+    "load",
+    "load.read",
+    "load.parse",
+    "load.media",
+    "gui.renderSlide",
+    "gui.paint",
+};
+static_assert(sizeof(kNames) / sizeof(kNames[0]) == static_cast<size_t>(Phase::Count));
+
+std::string formatNs(uint64_t ns)
+{
+    char buf[32];
+    if (ns < 1000) std::snprintf(buf, sizeof(buf), "%lluns", static_cast<unsigned long long>(ns));
+    else if (ns < 1000000) std::snprintf(buf, sizeof(buf), "%.1fus", ns / 1e3);
+    else if (ns < 1000000000) std::snprintf(buf, sizeof(buf), "%.2fms", ns / 1e6);
+    else std::snprintf(buf, sizeof(buf), "%.2fs", ns / 1e9);
+    return buf;
+}
+
+} // namespace
+
+const char* phaseName(Phase p)
+{
+    const size_t i = static_cast<size_t>(p);
+    return i < static_cast<size_t>(Phase::Count) ? kNames[i] : "?";
+}
+
+void record(Phase p, uint64_t startNs, uint64_t endNs)
+{
+    const size_t i = static_cast<size_t>(p);
+    if (i >= static_cast<size_t>(Phase::Count)) return;
+    const uint64_t ns = endNs >= startNs ? endNs - startNs : 0;
+
+    Histogram& h = g_hist[i];
+    h.total.fetch_add(ns, std::memory_order_relaxed);
+    h.buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t cur = h.max.load(std::memory_order_relaxed);
+    while (ns > cur && !h.max.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {}
+
+    traceEvent(kNames[i], startNs, endNs);
+}
+
+std::vector<PhaseStats> collect()
+{
+    std::vector<PhaseStats> out;
+    for (size_t i = 0; i < static_cast<size_t>(Phase::Count); ++i) {
+        const Histogram& h = g_hist[i];
+
+        // The count is the bucket sum so percentiles stay consistent even
+        // while other threads record.
+        uint64_t counts[kBuckets];
+        uint64_t n = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            counts[b] = h.buckets[b].load(std::memory_order_relaxed);
+            n += counts[b];
+        }
+        if (n == 0) continue;
+
+        PhaseStats st;
+        st.phase = static_cast<Phase>(i);
+        st.count = n;
+        st.totalNs = h.total.load(std::memory_order_relaxed);
+        st.maxNs = h.max.load(std::memory_order_relaxed);
+
+        // Nearest rank, ceil(pct/100 * n) in integers: the reported value is
+        // one that at least pct% of the samples do not exceed.
+        auto percentile = [&](uint64_t pct) {
+            const uint64_t rank = std::max<uint64_t>(1, (n * pct + 99) / 100);
+            uint64_t seen = 0;
+            for (int b = 0; b < kBuckets; ++b) {
+                seen += counts[b];
+                if (seen >= rank) return std::min(bucketUpper(b), st.maxNs);
+            }
+            return st.maxNs;
+        };
+        st.p50Ns = percentile(50);
+        st.p99Ns = percentile(99);
+        out.push_back(st);
+    }
+    return out;
+}
+
+void reset()
+{
+    for (auto& h : g_hist) {
+        h.total.store(0, std::memory_order_relaxed);
+        h.max.store(0, std::memory_order_relaxed);
+        for (auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+    }
+}
+
+void report(std::ostream& os)
+{
+    const std::vector<PhaseStats> stats = collect();
+    if (stats.empty()) return;
+
+    os << std::left << std::setw(18) << "phase" << std::right
+       << std::setw(10) << "count" << std::setw(11) << "p50" << std::setw(11) << "p99"
+       << std::setw(11) << "max" << std::setw(11) << "total" << "\n";
+    for (const auto& s : stats) {
+        os << std::left << std::setw(18) << phaseName(s.phase) << std::right
+           << std::setw(10) << s.count
+           << std::setw(11) << formatNs(s.p50Ns)
+           << std::setw(11) << formatNs(s.p99Ns)
+           << std::setw(11) << formatNs(s.maxNs)
+           << std::setw(11) << formatNs(s.totalNs) << "\n";
+    }
+}
+
+} // namespace prof
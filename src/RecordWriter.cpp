@@ -0,0 +1,125 @@
+#include "RecordWriter.hpp"
+
+#include "Json.hpp"
+#include "Log.hpp"
+#include "Shape.hpp"
+
+#include <atomic>
+#include <charconv>
+
+namespace {
+
+std::atomic<int> g_format{static_cast<int>(OutputFormat::Text)};
+
+constexpr size_t kFlushBytes = 64 * 1024;
+
+} // namespace
+
+bool parseOutputFormat(const std::string& name, OutputFormat& out)
+{
+    if (name == "text") out = OutputFormat::Text;
+    else if (name == "json") out = OutputFormat::Json;
+    else if (name == "tsv") out = OutputFormat::Tsv;
+    else return false;
+    return true;
+}
+
+void setOutputFormat(OutputFormat format) { g_format.store(static_cast<int>(format), std::memory_order_relaxed); }
+
+OutputFormat outputFormat() { return static_cast<OutputFormat>(g_format.load(std::memory_order_relaxed)); }
+
+RecordWriter::RecordWriter(OutputFormat format, std::string type, std::initializer_list<const char*> columns)
+    : format_(format), type_(std::move(type)), columns_(columns)
+{
+    if (format_ != OutputFormat::Tsv) return;
+    buf_ += "type";
+    for (const char* c : columns_) {
+        buf_ += '\t';
+        buf_ += c;
+    }
+    buf_ += '\n';
+}
+
+RecordWriter::~RecordWriter() { flush(); }
+
+void RecordWriter::key()
+{
+    if (format_ == OutputFormat::Json) {
+        if (column_ == 0) {
+            buf_ += "{\"type\":";
+            json::appendString(buf_, type_);
+        }
+        buf_ += ",\"";
+        buf_ += column_ < columns_.size() ? columns_[column_] : "?";
+        buf_ += "\":";
+    } else {
+        if (column_ == 0) buf_ += type_;
+        buf_ += '\t';
+    }
+    ++column_;
+}
+
+RecordWriter& RecordWriter::field(int64_t value)
+{
+    key();
+    char tmp[24];
+    const auto r = std::to_chars(tmp, tmp + sizeof(tmp), value);
+    buf_.append(tmp, r.ptr);
+    return *this;
+}
+
+RecordWriter& RecordWriter::field(std::string_view value)
+{
+    key();
+    if (format_ == OutputFormat::Json) {
+        json::appendString(buf_, value);
+        return *this;
+    }
+    size_t run = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        if (c != '\t' && c != '\n' && c != '\r' && c != '\\') continue;
+        buf_.append(value.data() + run, i - run);
+        run = i + 1;
+        buf_ += '\\';
+        buf_ += c == '\t' ? 't' : c == '\n' ? 'n' : c == '\r' ? 'r' : '\\';
+    }
+    buf_.append(value.data() + run, value.size() - run);
+    return *this;
+}
+
+RecordWriter& RecordWriter::null()
+{
+    key();
+    if (format_ == OutputFormat::Json) buf_ += "null";
+    return *this;
+}
+
+void RecordWriter::end()
+{
+    if (format_ == OutputFormat::Json) buf_ += "}\n";
+    else buf_ += '\n';
+    column_ = 0;
+    if (buf_.size() >= kFlushBytes) flush();
+}
+
+void RecordWriter::flush()
+{
+    if (buf_.empty()) return;
+    out() << std::string_view(buf_);
+    buf_.clear();
+}
+
+void writeShapeRecords(OutputFormat format, size_t slideNumber, const std::vector<Shape>& shapes)
+{
+    RecordWriter w(format, "shape", {"slide", "index", "id", "kind", "x", "y", "w", "h", "bytes", "text"});
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        const Shape& sh = shapes[i];
+        w.field(static_cast<int64_t>(slideNumber)).field(static_cast<int64_t>(i + 1))
+         .field(static_cast<int64_t>(sh.getId())).field(shapeKindName(sh.kind()))
+         .field(sh.getX()).field(sh.getY()).field(sh.getW()).field(sh.getH());
+        if (sh.isImage()) w.field(static_cast<int64_t>(sh.getImageData().size()));
+        else w.null();
+        w.field(sh.getText()).end();
+    }
+}
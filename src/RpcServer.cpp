@@ -0,0 +1,519 @@
+#include "RpcServer.hpp"
+
+#include "AsyncTask.hpp"
+#include "CommandParser.hpp"
+#include "Commands.hpp"
+#include "Session.hpp"
+#include "Log.hpp"
+#include "Json.hpp"
+#include "Profiler.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+void RpcServer::setHistoryLimit(size_t states) { historyLimit_ = states; }
+
+#if defined(__linux__)
+
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Lines longer than this without a newline are treated as a broken client.
+constexpr size_t kMaxLineBytes = 16 * 1024 * 1024;
+
+enum RpcError {
+    kParseError = -32700,
+    kInvalidRequest = -32600,
+    kInvalidParams = -32602,
+};
+
+// Routes std::cout into a buffer while a request's command runs.
+class CoutCapture
+{
+public:
+    CoutCapture() : old_(std::cout.rdbuf(buf_.rdbuf())) {}
+    ~CoutCapture() { std::cout.rdbuf(old_); }
+    std::string take() { std::cout.flush(); return buf_.str(); }
+
+private:
+    std::ostringstream buf_;
+    std::streambuf* old_;
+};
+
+// Converts a JSON param into one command-line argument for the Tokenizer.
+// False for a string the command line cannot carry: the tokenizer has no
+// escapes, so a '"' would end or split the argument.
+bool appendArg(std::string& line, const json::Value& v)
+{
+    line += ' ';
+    if (v.isNumber()) {
+        char buf[32];
+        const double d = v.number;
+        auto r = (d == std::floor(d) && std::fabs(d) < 1e15)
+                     ? std::to_chars(buf, buf + sizeof(buf), static_cast<long long>(d))
+                     : std::to_chars(buf, buf + sizeof(buf), d);
+        line.append(buf, r.ptr);
+        return true;
+    }
+
+    const std::string s = v.isString() ? v.string : std::string();
+    if (s.find('"') != std::string::npos) return false;
+    if (s.empty() || s.find_first_of(" \t") != std::string::npos) line += '"' + s + '"';
+    else line += s;
+    return true;
+}
+
+void appendOutputLines(std::string& out, const std::string& text)
+{
+    out += '[';
+    bool first = true;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t nl = text.find('\n', start);
+        if (nl == std::string::npos) nl = text.size();
+        size_t end = nl;
+        if (end > start && text[end - 1] == '\r') --end;
+        if (end > start) {
+            if (!first) out += ',';
+            json::appendString(out, std::string_view(text).substr(start, end - start));
+            first = false;
+        }
+        start = nl + 1;
+    }
+    out += ']';
+}
+
+void appendState(std::string& out, const Session& session)
+{
+    const auto& shows = session.getSlideshows();
+    out += "{\"presentations\":" + std::to_string(shows.size());
+    if (!shows.empty()) {
+        const SlideShow& ss = session.getCurrentSlideshow();
+        const size_t slides = ss.getSlides().size();
+        out += ",\"presentation\":" + std::to_string(session.getCurrentIndex() + 1);
+        out += ",\"name\":";
+        json::appendString(out, ss.getFilename());
+        out += ",\"slides\":" + std::to_string(slides);
+        if (slides > 0) {
+            out += ",\"slide\":" + std::to_string(ss.getCurrentIndex() + 1);
+            out += ",\"shapes\":" + std::to_string(ss.currentSlide().getShapes().size());
+        }
+    }
+    out += '}';
+}
+
+void appendId(std::string& out, const json::Value& id)
+{
+    out += "{\"jsonrpc\":\"2.0\",\"id\":";
+    json::append(out, id);
+}
+
+void appendError(std::string& out, const json::Value& id, int code, const std::string& msg,
+                 const std::string& output = std::string())
+{
+    appendId(out, id);
+    out += ",\"error\":{\"code\":" + std::to_string(code) + ",\"message\":";
+    json::appendString(out, msg);
+    if (!output.empty()) {
+        out += ",\"data\":{\"output\":";
+        appendOutputLines(out, output);
+        out += '}';
+    }
+    out += "}}\n";
+}
+
+// `ok` is false if the command logged an error, whether or not the level
+// filter let it into `output`.
+void appendResult(std::string& out, const json::Value& id, bool ok, const std::string& output,
+                  const Session& session)
+{
+    appendId(out, id);
+    out += ",\"result\":{\"ok\":";
+    out += ok ? "true" : "false";
+    out += ",\"output\":";
+    appendOutputLines(out, output);
+    out += ",\"state\":";
+    appendState(out, session);
+    out += "}}\n";
+}
+
+} // namespace
+
+struct RpcServer::Connection
+{
+    int fd = -1;
+    std::string in;
+    std::string out;
+    bool peerClosed = false;
+    uint32_t events = EPOLLIN | EPOLLRDHUP;  // as registered with epoll
+
+    Session session;
+
+    // A request whose I/O runs in the background; this client's later
+    // requests wait in `in` until it completes.
+    std::shared_ptr<AsyncTask> task;
+    json::Value taskId;
+    std::string taskOutput;
+    bool taskFailed = false;  // an error was logged while starting it
+};
+
+RpcServer::RpcServer(std::string socketPath) : path_(std::move(socketPath)) {}
+
+RpcServer::~RpcServer()
+{
+    while (!conns_.empty()) closeConnection(conns_.begin()->first);
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        ::unlink(path_.c_str());
+    }
+    if (epollFd_ >= 0) ::close(epollFd_);
+    if (wakeFd_ >= 0) ::close(wakeFd_);
+}
+
+bool RpcServer::listen()
+{
+    sockaddr_un addr{};
+    if (path_.empty() || path_.size() >= sizeof(addr.sun_path)) {
+        error() << "Invalid socket path: " << path_ << "\n";
+        return false;
+    }
+
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        error() << "socket(): " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+    ::unlink(path_.c_str());
+
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd_, SOMAXCONN) != 0) {
+        error() << "Cannot listen on " << path_ << ": " << std::strerror(errno) << "\n";
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        error() << "epoll/eventfd: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd_;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev);
+    ev.data.fd = wakeFd_;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    // Output goes back to clients, never to a terminal.
+    ::setenv("SLIDESHOW_NO_COLOR", "1", 1);
+    return true;
+}
+
+void RpcServer::stop()
+{
+    stopping_.store(true);
+    if (wakeFd_ >= 0) {
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+void RpcServer::run()
+{
+    if (listenFd_ < 0) return;
+    info() << "Serving JSON-RPC on " << path_ << "\n";
+
+    epoll_event events[64];
+    while (!stopping_.load()) {
+        bool tasksPending = false;
+        for (const auto& [fd, c] : conns_)
+            if (c->task) { tasksPending = true; break; }
+
+        const int n = ::epoll_wait(epollFd_, events, 64, tasksPending ? 10 : -1);
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd_) { acceptClients(); continue; }
+            if (fd == wakeFd_) {
+                uint64_t v = 0;
+                [[maybe_unused]] ssize_t r = ::read(wakeFd_, &v, sizeof(v));
+                continue;
+            }
+
+            auto it = conns_.find(fd);
+            if (it == conns_.end()) continue;
+            Connection& c = *it->second;
+
+            if (events[i].events & EPOLLERR) { closeConnection(fd); continue; }
+            if (events[i].events & (EPOLLIN | EPOLLHUP)) onReadable(c);
+            if (!conns_.count(fd)) continue;
+            // EPOLLHUP cannot be masked: with the peer fully gone and a task
+            // still running it would fire on every wait, and nobody is left
+            // to read the reply anyway.
+            if ((events[i].events & EPOLLHUP) && c.task) { closeConnection(fd); continue; }
+            if (events[i].events & EPOLLOUT) onWritable(c);
+        }
+
+        pollTasks();
+    }
+}
+
+void RpcServer::acceptClients()
+{
+    while (true) {
+        const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        auto c = std::make_unique<Connection>();
+        c->fd = fd;
+        c->session.setHistoryLimit(historyLimit_);
+
+        epoll_event ev{};
+        ev.events = c->events;
+        ev.data.fd = fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+        conns_[fd] = std::move(c);
+    }
+}
+
+void RpcServer::onReadable(Connection& c)
+{
+    char buf[64 * 1024];
+    while (true) {
+        const ssize_t n = ::read(c.fd, buf, sizeof(buf));
+        if (n > 0) {
+            c.in.append(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) c.peerClosed = true;
+        else if (errno == EINTR) continue;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK) c.peerClosed = true;
+        break;
+    }
+
+    const int fd = c.fd;
+    processLines(c);
+    if (!conns_.count(fd)) return;
+
+    if (c.in.size() > kMaxLineBytes ||
+        (c.peerClosed && !c.task && c.out.empty())) {
+        closeConnection(fd);
+        return;
+    }
+    if (!c.out.empty()) onWritable(c);
+    else updateInterest(c);
+}
+
+void RpcServer::onWritable(Connection& c)
+{
+    while (!c.out.empty()) {
+        const ssize_t n = ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            c.out.erase(0, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closeConnection(c.fd);
+        return;
+    }
+
+    if (c.out.empty() && c.peerClosed && !c.task) {
+        closeConnection(c.fd);
+        return;
+    }
+    updateInterest(c);
+}
+
+void RpcServer::updateInterest(Connection& c)
+{
+    // Once the peer has closed its end, EPOLLIN stays ready (read returns
+    // 0), so reading interest is dropped while a task or reply is pending.
+    uint32_t want = c.peerClosed ? 0u : EPOLLIN | EPOLLRDHUP;
+    if (!c.out.empty()) want |= EPOLLOUT;
+    if (want == c.events) return;
+    c.events = want;
+
+    epoll_event ev{};
+    ev.events = want;
+    ev.data.fd = c.fd;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, c.fd, &ev);
+}
+
+void RpcServer::processLines(Connection& c)
+{
+    size_t start = 0;
+    while (!c.task) {
+        const size_t nl = c.in.find('\n', start);
+        if (nl == std::string::npos) break;
+
+        size_t end = nl;
+        if (end > start && c.in[end - 1] == '\r') --end;
+        if (end > start) handleRequest(c, c.in.substr(start, end - start));
+        start = nl + 1;
+    }
+    c.in.erase(0, start);
+}
+
+void RpcServer::handleRequest(Connection& c, const std::string& line)
+{
+    json::Value req;
+    std::string perr;
+    if (!json::parse(line, req, &perr)) {
+        appendError(c.out, json::Value{}, kParseError, "Parse error: " + perr);
+        return;
+    }
+
+    json::Value id;
+    if (const json::Value* v = req.find("id")) id = *v;
+
+    const json::Value* method = req.find("method");
+    if (!method || !method->isString() || method->string.empty()) {
+        appendError(c.out, id, kInvalidRequest, "Missing method");
+        return;
+    }
+    const json::Value* params = req.find("params");
+
+    Session& session = c.session;
+
+    if (method->string == "state") {
+        appendResult(c.out, id, true, std::string(), session);
+        return;
+    }
+
+    std::string cmdLine;
+    if (method->string == "execute") {
+        const json::Value* cmd = nullptr;
+        if (params && params->isObject()) cmd = params->find("command");
+        else if (params && params->isArray() && !params->array.empty()) cmd = &params->array[0];
+        if (!cmd || !cmd->isString()) {
+            appendError(c.out, id, kInvalidParams, "execute needs params {\"command\": \"...\"}");
+            return;
+        }
+        cmdLine = cmd->string;
+    } else {
+        cmdLine = method->string;
+        bool valid = true;
+        if (params && params->isArray())
+            for (const auto& p : params->array) valid = appendArg(cmdLine, p) && valid;
+        else if (params && !params->isNull())
+            valid = appendArg(cmdLine, *params);
+        if (!valid) {
+            appendError(c.out, id, kInvalidParams, "String params cannot contain '\"'");
+            return;
+        }
+    }
+
+    if (cmdLine == "exit") {
+        appendResult(c.out, id, true, std::string(), session);
+        c.peerClosed = true;
+        return;
+    }
+
+    CoutCapture capture;
+    const size_t errorsBefore = logging::errorCount();
+    std::istringstream iss(cmdLine);
+    std::unique_ptr<ICommand> cmd = CommandParser::parse(iss, session);
+    if (!cmd) {
+        appendError(c.out, id, kInvalidParams, "Invalid command", capture.take());
+        return;
+    }
+
+    if (isUndoableCommand(cmd.get())) session.snapshot();
+
+    if (auto* async = dynamic_cast<IAsyncCommand*>(cmd.get())) {
+        c.task = async->startAsync();
+        if (c.task) {
+            c.taskId = id;
+            c.taskOutput = capture.take();
+            c.taskFailed = logging::errorCount() != errorsBefore;
+            return;
+        }
+    } else {
+        PROFILE_SCOPE(prof::Phase::Execute);
+        cmd->execute();
+    }
+    session.rebuildUiIndex();
+
+    const bool ok = logging::errorCount() == errorsBefore;
+    appendResult(c.out, id, ok, capture.take(), session);
+}
+
+void RpcServer::pollTasks()
+{
+    std::vector<int> ready;
+    for (const auto& [fd, c] : conns_)
+        if (c->task && c->task->isReady()) ready.push_back(fd);
+
+    for (int fd : ready) {
+        Connection& c = *conns_[fd];
+        {
+            CoutCapture capture;
+            const size_t errorsBefore = logging::errorCount();
+            c.task->complete();
+            c.session.rebuildUiIndex();
+            const bool ok = !c.taskFailed && logging::errorCount() == errorsBefore;
+            appendResult(c.out, c.taskId, ok, c.taskOutput + capture.take(), c.session);
+        }
+        c.task.reset();
+        c.taskOutput.clear();
+        c.taskFailed = false;
+
+        processLines(c);
+        if (conns_.count(fd)) onWritable(c);
+    }
+}
+
+void RpcServer::closeConnection(int fd)
+{
+    auto it = conns_.find(fd);
+    if (it == conns_.end()) return;
+    Connection& c = *it->second;
+
+    if (c.task) {
+        // Its completion refers to this client's session, so run it before
+        // the session goes away.
+        c.task->cancel();
+        CoutCapture capture;
+        c.task->complete();
+    }
+
+    ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    conns_.erase(it);
+}
+
+#else // !__linux__
+
+struct RpcServer::Connection {};
+
+RpcServer::RpcServer(std::string socketPath) : path_(std::move(socketPath)) {}
+RpcServer::~RpcServer() = default;
+
+bool RpcServer::listen()
+{
+    error() << "--serve is only available on Linux\n";
+    return false;
+}
+
+void RpcServer::run() {}
+void RpcServer::stop() { stopping_.store(true); }
+
+#endif
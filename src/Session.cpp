@@ -0,0 +1,240 @@
+#include "Session.hpp"
+#include "Profiler.hpp"
+
+#include <unordered_set>
+
+std::vector<SlideShow>& Session::getSlideshows() { return slideshows_; }
+const std::vector<SlideShow>& Session::getSlideshows() const { return slideshows_; }
+
+const std::vector<std::string>& Session::getPresentationOrder() const { return presentationOrder_; }
+const PresentationIndex& Session::getPresentationIndex() const { return presentationIndex_; }
+
+size_t& Session::getCurrentIndex() { return currentIndex_; }
+size_t Session::getCurrentIndex() const { return currentIndex_; }
+
+void Session::normalizeCurrentIndex()
+{
+    if (slideshows_.empty()) {
+        currentIndex_ = 0;
+        return;
+    }
+    if (currentIndex_ >= slideshows_.size()) currentIndex_ = 0;
+}
+
+void Session::ensureOrderIndexConsistent()
+{
+    presentationIndex_.clear();
+    presentationIndex_.reserve(slideshows_.size());
+    for (size_t i = 0; i < slideshows_.size(); ++i) {
+        presentationIndex_[slideshows_[i].getFilename()] = i;
+    }
+
+    // Keep the known order for presentations that still exist, then append
+    // the rest in list order. Each name appears once.
+    std::vector<std::string> newOrder;
+    newOrder.reserve(presentationIndex_.size());
+    std::unordered_set<std::string> placed;
+    placed.reserve(presentationIndex_.size());
+
+    for (auto& name : presentationOrder_) {
+        if (presentationIndex_.count(name) && placed.insert(name).second)
+            newOrder.push_back(std::move(name));
+    }
+    for (const auto& ss : slideshows_) {
+        if (placed.insert(ss.getFilename()).second)
+            newOrder.push_back(ss.getFilename());
+    }
+
+    presentationOrder_ = std::move(newOrder);
+    presentationsDirty_ = false;
+
+    normalizeCurrentIndex();
+}
+
+void Session::rebuildUiIndex()
+{
+    PROFILE_SCOPE(prof::Phase::RebuildIndex);
+    if (presentationsDirty_) ensureOrderIndexConsistent();
+    else normalizeCurrentIndex();
+}
+
+void Session::markPresentationsDirty()
+{
+    presentationsDirty_ = true;
+    notifySlides({SlideEdit::Kind::Reset});
+}
+
+void Session::addPresentation(SlideShow ss)
+{
+    const std::string name = ss.getFilename();
+    slideshows_.push_back(std::move(ss));
+    currentIndex_ = slideshows_.size() - 1;
+
+    if (presentationIndex_.insert_or_assign(name, currentIndex_).second)
+        presentationOrder_.push_back(name);
+    notifySlides({SlideEdit::Kind::Reset});
+}
+
+void Session::replacePresentations(std::vector<SlideShow> slideshows,
+                                   std::vector<std::string> order,
+                                   size_t currentIndex)
+{
+    slideshows_ = std::move(slideshows);
+    presentationOrder_ = std::move(order);
+    currentIndex_ = currentIndex;
+    ensureOrderIndexConsistent();
+    notifySlides({SlideEdit::Kind::Reset});
+}
+
+size_t Session::findPresentation(const std::string& name) const
+{
+    auto it = presentationIndex_.find(name);
+    return (it == presentationIndex_.end()) ? std::string::npos : it->second;
+}
+
+ShapeTextIndex& Session::getTextIndex() { return textIndex_; }
+
+std::vector<ShapeTextIndex::Hit> Session::findText(const std::string& needle)
+{
+    return textIndex_.search(slideshows_, needle);
+}
+
+SlideShow& Session::getCurrentSlideshow()
+{
+    normalizeCurrentIndex();
+    if (slideshows_.empty()) {
+        replacePresentations({}, {}, 0);
+        addPresentation(SlideShow("Presentation"));
+    }
+    normalizeCurrentIndex();
+    return slideshows_[currentIndex_];
+}
+
+const SlideShow& Session::getCurrentSlideshow() const
+{
+    if (slideshows_.empty()) {
+        static SlideShow dummy("Presentation");
+        return dummy;
+    }
+    size_t idx = currentIndex_;
+    if (idx >= slideshows_.size()) idx = 0;
+    return slideshows_[idx];
+}
+
+void Session::setAutoSaveOnExit(bool on) { autosaveOnExit_ = on; }
+bool Session::getAutoSaveOnExit() const { return autosaveOnExit_; }
+
+Session::SnapshotState Session::packState() const
+{
+    SnapshotState st;
+    st.slideshows = slideshows_;
+    st.order = presentationOrder_;
+    st.currentIndex = currentIndex_;
+    st.autosaveOnExit = autosaveOnExit_;
+    return st;
+}
+
+void Session::restoreState(const SnapshotState& st)
+{
+    slideshows_ = st.slideshows;
+    presentationOrder_ = st.order;
+    currentIndex_ = st.currentIndex;
+    autosaveOnExit_ = st.autosaveOnExit;
+    // Shape ids survive snapshots, so only shapes that differ get re-indexed.
+    textIndex_.markStale();
+    ensureOrderIndexConsistent();
+    notifySlides({SlideEdit::Kind::Reset});
+}
+
+void Session::snapshot()
+{
+    PROFILE_SCOPE(prof::Phase::Snapshot);
+    undo_.push_back(packState());
+    redo_.clear();
+    if (historyLimit_ && undo_.size() > historyLimit_) undo_.pop_front();
+}
+
+void Session::setHistoryLimit(size_t states)
+{
+    historyLimit_ = states;
+    while (historyLimit_ && undo_.size() > historyLimit_) undo_.pop_front();
+}
+
+size_t Session::historyLimit() const { return historyLimit_; }
+
+bool Session::undo()
+{
+    if (undo_.empty()) return false;
+
+    redo_.push_back(packState());
+    SnapshotState st = undo_.back();
+    undo_.pop_back();
+    restoreState(st);
+    return true;
+}
+
+bool Session::redo()
+{
+    if (redo_.empty()) return false;
+
+    undo_.push_back(packState());
+    if (historyLimit_ && undo_.size() > historyLimit_) undo_.pop_front();
+    SnapshotState st = redo_.back();
+    redo_.pop_back();
+    restoreState(st);
+    return true;
+}
+
+void Session::setSlideListener(std::function<void(const SlideEdit&)> fn)
+{
+    slideListener_ = std::move(fn);
+}
+
+void Session::notifySlides(const SlideEdit& edit)
+{
+    if (slideListener_) slideListener_(edit);
+}
+
+size_t Session::undoDepth() const { return undo_.size(); }
+size_t Session::redoDepth() const { return redo_.size(); }
+
+void Session::forEachHistoryState(
+    const std::function<void(bool redo, const std::vector<SlideShow>&)>& fn) const
+{
+    for (const auto& st : undo_) fn(false, st.slideshows);
+    for (const auto& st : redo_) fn(true, st.slideshows);
+}
+
+bool Session::startRecording(const std::string& name)
+{
+    if (recording_ || name.empty()) return false;
+    recording_ = true;
+    recordingName_ = name;
+    recordedLines_.clear();
+    return true;
+}
+
+bool Session::isRecording() const { return recording_; }
+const std::string& Session::getRecordingName() const { return recordingName_; }
+
+void Session::recordLine(const std::string& line)
+{
+    if (recording_) recordedLines_.push_back(line);
+}
+
+std::vector<std::string> Session::stopRecording()
+{
+    recording_ = false;
+    return std::move(recordedLines_);
+}
+
+void Session::setMacro(const std::string& name, Macro m)
+{
+    macros_[name] = std::move(m);
+}
+
+Macro* Session::findMacro(const std::string& name)
+{
+    auto it = macros_.find(name);
+    return (it == macros_.end()) ? nullptr : &it->second;
+}
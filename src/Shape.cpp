@@ -1,9 +1,36 @@
 #include "../include/Shape.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cstring>
 #include <string>
 
+static uint64_t nextShapeId()
+{
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+// 64-bit content hash, 8 bytes per step.
+static uint64_t hashBytes(const std::vector<uint8_t>& data)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ data.size();
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        uint64_t w = 0;
+        std::memcpy(&w, data.data() + i, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    for (; i < data.size(); ++i) {
+        h = (h ^ data[i]) * 0x100000001B3ull;
+    }
+    h ^= h >> 29;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 32);
+}
+
 static std::string toLowerCopy(std::string s)
 {
     std::transform(s.begin(), s.end(), s.begin(),
@@ -44,6 +71,7 @@ static bool parseIntStrict(const std::string& s, int& out)
 
 Shape::Shape(std::string n, int px, int py)
 {
+    id_ = nextShapeId();
     x_ = px;
     y_ = py;
 
@@ -59,11 +87,13 @@ Shape::Shape(std::string n, int px, int py)
 
 Shape::Shape(std::string n, int px, int py, std::vector<uint8_t> data)
 {
+    id_ = nextShapeId();
     name_ = std::move(n);
     text_ = name_;
     x_ = px;
     y_ = py;
-    imageData_ = std::move(data);
+    imageHash_ = hashBytes(data);
+    imageData_ = std::make_shared<const std::vector<uint8_t>>(std::move(data));
     kind_ = ShapeKind::Image;
     w_ = 1;
     h_ = 1;
@@ -71,6 +101,7 @@ Shape::Shape(std::string n, int px, int py, std::vector<uint8_t> data)
 
 Shape::Shape(std::string n, int px, int py, ShapeKind k, int w, int h)
 {
+    id_ = nextShapeId();
     name_ = std::move(n);
     text_ = name_;
     x_ = px;
@@ -133,6 +164,9 @@ void Shape::parseSpecialSyntax(const std::string& raw)
     name_ = text_.empty() ? std::string(isRect ? "Rect" : "Ellipse") : text_;
 }
 
+uint64_t Shape::getId() const { return id_; }
+void Shape::assignNewId() { id_ = nextShapeId(); }
+
 const std::string& Shape::getName() const { return name_; }
 const std::string& Shape::getText() const { return text_; }
 
@@ -156,7 +190,12 @@ void Shape::setText(const std::string& t)
 
 ShapeKind Shape::kind() const { return kind_; }
 
-const std::vector<uint8_t>& Shape::getImageData() const { return imageData_; }
+const std::vector<uint8_t>& Shape::getImageData() const
+{
+    static const std::vector<uint8_t> none;
+    return imageData_ ? *imageData_ : none;
+}
+uint64_t Shape::getImageHash() const { return imageHash_; }
 bool Shape::isImage() const { return kind_ == ShapeKind::Image; }
 
 static int clampCropPct(int v)
@@ -183,3 +222,12 @@ void Shape::setCrop(int l, int t, int r, int b)
     if (cropT_ + cropB_ > 99999) cropB_ = std::max(0, 99999 - cropT_);
 }
 
+const char* shapeKindName(ShapeKind k)
+{
+    switch (k) {
+    case ShapeKind::Text: return "Text";
+    case ShapeKind::Image: return "Image";
+    case ShapeKind::Rect: return "Rect";
+    default: return "Ellipse";
+    }
+}
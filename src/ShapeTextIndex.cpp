@@ -0,0 +1,332 @@
+#include "ShapeTextIndex.hpp"
+
+#include "SlideShow.hpp"
+#include "Slide.hpp"
+#include "Shape.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+namespace {
+
+// Keys: trigrams use the low 24 bits, bigrams are tagged in the top byte.
+constexpr uint32_t kBigram = 1u << 24;
+
+uint32_t byteAt(const std::string& s, size_t i) { return static_cast<unsigned char>(s[i]); }
+
+uint32_t trigramKey(const std::string& s, size_t i)
+{
+    return (byteAt(s, i) << 16) | (byteAt(s, i + 1) << 8) | byteAt(s, i + 2);
+}
+
+uint32_t bigramKey(const std::string& s, size_t i) { return kBigram | (byteAt(s, i) << 8) | byteAt(s, i + 1); }
+
+constexpr size_t kBigramSlots = 65536;
+
+void insertSorted(std::vector<uint64_t>& list, uint64_t id)
+{
+    auto it = std::lower_bound(list.begin(), list.end(), id);
+    if (it == list.end() || *it != id) list.insert(it, id);
+}
+
+bool locationLess(const ShapeTextIndex::Hit& a, const ShapeTextIndex::Hit& b)
+{
+    if (a.where.presentation != b.where.presentation) return a.where.presentation < b.where.presentation;
+    if (a.where.slide != b.where.slide) return a.where.slide < b.where.slide;
+    return a.where.shape < b.where.shape;
+}
+
+} // namespace
+
+std::string ShapeTextIndex::fold(const std::string& s)
+{
+    std::string out(s);
+    std::transform(out.begin(), out.end(), out.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return out;
+}
+
+bool ShapeTextIndex::sameFolded(const std::string& folded, const std::string& raw)
+{
+    if (folded.size() != raw.size()) return false;
+    for (size_t i = 0; i < raw.size(); ++i)
+        if (static_cast<char>(std::tolower(static_cast<unsigned char>(raw[i]))) != folded[i]) return false;
+    return true;
+}
+
+std::vector<uint32_t> ShapeTextIndex::grams(const std::string& folded)
+{
+    std::vector<uint32_t> out;
+    if (folded.size() < 2) return out;
+    out.reserve(folded.size() * 2);
+    for (size_t i = 0; i + 1 < folded.size(); ++i) {
+        out.push_back(bigramKey(folded, i));
+        if (i + 2 < folded.size()) out.push_back(trigramKey(folded, i));
+    }
+    return out;
+}
+
+std::vector<uint32_t> ShapeTextIndex::needleGrams(const std::string& folded)
+{
+    std::vector<uint32_t> out;
+    if (folded.size() == 2) out.push_back(bigramKey(folded, 0));
+    else {
+        for (size_t i = 0; i + 2 < folded.size(); ++i) out.push_back(trigramKey(folded, i));
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+    return out;
+}
+
+void ShapeTextIndex::clear()
+{
+    bigrams_.assign(kBigramSlots, {});
+    trigrams_.clear();
+    entries_.clear();
+}
+
+std::vector<uint64_t>& ShapeTextIndex::listFor(uint32_t key)
+{
+    if (key < kBigram) return trigrams_[key];
+    if (bigrams_.empty()) bigrams_.resize(kBigramSlots);
+    return bigrams_[key & 0xFFFF];
+}
+
+const std::vector<uint64_t>* ShapeTextIndex::findList(uint32_t key) const
+{
+    if (key < kBigram) {
+        auto it = trigrams_.find(key);
+        return it == trigrams_.end() ? nullptr : &it->second;
+    }
+    if (bigrams_.empty()) return nullptr;
+    const auto& list = bigrams_[key & 0xFFFF];
+    return list.empty() ? nullptr : &list;
+}
+
+void ShapeTextIndex::invalidate()
+{
+    clear();
+    valid_ = false;
+    stale_ = false;
+}
+
+void ShapeTextIndex::markStale()
+{
+    if (valid_) stale_ = true;
+}
+
+bool ShapeTextIndex::isValid() const { return valid_; }
+
+size_t ShapeTextIndex::size() const { return entries_.size(); }
+
+void ShapeTextIndex::rebuild(const std::vector<SlideShow>& slideshows)
+{
+    clear();
+    Location at;
+    for (at.presentation = 0; at.presentation < slideshows.size(); ++at.presentation) {
+        const auto& slides = slideshows[at.presentation].getSlides();
+        for (at.slide = 0; at.slide < slides.size(); ++at.slide) {
+            const auto& shapes = slides[at.slide].getShapes();
+            for (at.shape = 0; at.shape < shapes.size(); ++at.shape) {
+                const Shape& sh = shapes[at.shape];
+                std::string folded = fold(sh.getText());
+                // A repeated gram finds this id already at the back.
+                for (uint32_t g : grams(folded)) {
+                    auto& list = listFor(g);
+                    if (list.empty() || list.back() != sh.getId()) list.push_back(sh.getId());
+                }
+                Entry& e = entries_[sh.getId()];
+                e.text = std::move(folded);
+                e.where = at;
+                e.located = true;
+            }
+        }
+    }
+    // Ids are unique and, for generated or freshly loaded decks, already
+    // ascending in document order.
+    auto sortList = [](std::vector<uint64_t>& list) {
+        if (!std::is_sorted(list.begin(), list.end())) std::sort(list.begin(), list.end());
+    };
+    for (auto& list : bigrams_) sortList(list);
+    for (auto& [g, list] : trigrams_) sortList(list);
+    valid_ = true;
+    stale_ = false;
+}
+
+void ShapeTextIndex::sync(const std::vector<SlideShow>& slideshows)
+{
+    struct Changed
+    {
+        const Shape* shape;
+        Location where;
+    };
+    std::vector<Changed> changed;
+
+    ++mark_;
+    size_t kept = 0;
+    Location at;
+    for (at.presentation = 0; at.presentation < slideshows.size(); ++at.presentation) {
+        const auto& slides = slideshows[at.presentation].getSlides();
+        for (at.slide = 0; at.slide < slides.size(); ++at.slide) {
+            const auto& shapes = slides[at.slide].getShapes();
+            for (at.shape = 0; at.shape < shapes.size(); ++at.shape) {
+                const Shape& sh = shapes[at.shape];
+                auto it = entries_.find(sh.getId());
+                if (it == entries_.end() || !sameFolded(it->second.text, sh.getText())) {
+                    changed.push_back({&sh, at});
+                    continue;
+                }
+                it->second.where = at;
+                it->second.located = true;
+                it->second.mark = mark_;
+                ++kept;
+            }
+        }
+    }
+
+    // Entries not marked above are gone or about to be re-indexed.
+    const size_t dropped = entries_.size() - kept;
+    if (changed.size() + dropped > entries_.size() / 4 + 256) {
+        rebuild(slideshows);
+        return;
+    }
+
+    std::vector<uint64_t> gone;
+    gone.reserve(dropped);
+    for (const auto& [id, e] : entries_)
+        if (e.mark != mark_) gone.push_back(id);
+    for (uint64_t id : gone) erase(id);
+    for (const auto& c : changed) insertFolded(c.shape->getId(), fold(c.shape->getText()), &c.where);
+    stale_ = false;
+}
+
+void ShapeTextIndex::insertFolded(uint64_t id, std::string folded, const Location* where)
+{
+    for (uint32_t g : grams(folded)) insertSorted(listFor(g), id);
+    Entry& e = entries_[id];
+    e.text = std::move(folded);
+    e.located = where != nullptr;
+    if (where) e.where = *where;
+    e.mark = mark_;
+}
+
+void ShapeTextIndex::erase(uint64_t id)
+{
+    auto it = entries_.find(id);
+    if (it == entries_.end()) return;
+
+    for (uint32_t g : grams(it->second.text)) {
+        auto& list = listFor(g);
+        auto pos = std::lower_bound(list.begin(), list.end(), id);
+        if (pos != list.end() && *pos == id) list.erase(pos);
+        if (list.empty() && g < kBigram) trigrams_.erase(g);
+    }
+    entries_.erase(it);
+}
+
+void ShapeTextIndex::add(const Shape& sh)
+{
+    if (!valid_) return;
+
+    // A text edit leaves the shape where it was. For a new shape the
+    // position is unknown; the next search looks it up.
+    Location where;
+    bool located = false;
+    if (auto it = entries_.find(sh.getId()); it != entries_.end()) {
+        where = it->second.where;
+        located = it->second.located;
+        erase(sh.getId());
+    }
+    insertFolded(sh.getId(), fold(sh.getText()), located ? &where : nullptr);
+}
+
+void ShapeTextIndex::update(const Shape& sh)
+{
+    add(sh);
+}
+
+void ShapeTextIndex::remove(uint64_t id)
+{
+    if (!valid_) return;
+    erase(id);
+}
+
+std::vector<uint64_t> ShapeTextIndex::find(const std::string& needle) const
+{
+    const std::string q = fold(needle);
+    std::vector<uint64_t> out;
+    if (q.size() < 2) {
+        for (const auto& [id, e] : entries_)
+            if (e.text.find(q) != std::string::npos) out.push_back(id);
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    std::vector<const std::vector<uint64_t>*> lists;
+    for (uint32_t g : needleGrams(q)) {
+        const std::vector<uint64_t>* list = findList(g);
+        if (!list) return out;
+        lists.push_back(list);
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    out = *lists.front();
+    std::vector<uint64_t> next;
+    for (size_t i = 1; i < lists.size() && !out.empty(); ++i) {
+        next.clear();
+        std::set_intersection(out.begin(), out.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(next));
+        out.swap(next);
+    }
+
+    // Up to three characters the gram is the needle. Longer needles can
+    // match trigrams out of order; confirm the actual substring.
+    if (q.size() > 3) {
+        out.erase(std::remove_if(out.begin(), out.end(), [&](uint64_t id) {
+                      auto e = entries_.find(id);
+                      return e == entries_.end() || e->second.text.find(q) == std::string::npos;
+                  }),
+                  out.end());
+    }
+    return out;
+}
+
+bool ShapeTextIndex::resolve(const std::vector<SlideShow>& slideshows, const std::vector<uint64_t>& ids,
+                             std::vector<Hit>& out) const
+{
+    out.clear();
+    out.reserve(ids.size());
+    for (uint64_t id : ids) {
+        auto it = entries_.find(id);
+        if (it == entries_.end() || !it->second.located) return false;
+
+        const Location& at = it->second.where;
+        if (at.presentation >= slideshows.size()) return false;
+        const auto& slides = slideshows[at.presentation].getSlides();
+        if (at.slide >= slides.size()) return false;
+        const auto& shapes = slides[at.slide].getShapes();
+        if (at.shape >= shapes.size() || shapes[at.shape].getId() != id) return false;
+
+        out.push_back({id, at});
+    }
+    std::sort(out.begin(), out.end(), locationLess);
+    return true;
+}
+
+std::vector<ShapeTextIndex::Hit> ShapeTextIndex::search(const std::vector<SlideShow>& slideshows,
+                                                        const std::string& needle)
+{
+    if (!valid_) rebuild(slideshows);
+    else if (stale_) sync(slideshows);
+
+    std::vector<Hit> hits;
+    if (resolve(slideshows, find(needle), hits)) return hits;
+
+    // Some hit moved (slides inserted or removed, shapes added) since
+    // positions were recorded.
+    sync(slideshows);
+    resolve(slideshows, find(needle), hits);
+    return hits;
+}
@@ -1,5 +1,6 @@
 #include "SlideShow.hpp"
-#include "Color.hpp"
+#include "Log.hpp"
+#include "RecordWriter.hpp"
 #include <iostream>
 
 SlideShow::SlideShow(std::string name) : filename(std::move(name)) {}
@@ -57,13 +58,17 @@ void SlideShow::show() const {
         info() << "No slides\n";
         return;
     }
-    info() << "Slide " << (currentIndex + 1) << "/" << slides.size() << "\n";
     const auto& shapes = slides[currentIndex].getShapes();
+    if (const OutputFormat fmt = outputFormat(); fmt != OutputFormat::Text) {
+        writeShapeRecords(fmt, currentIndex + 1, shapes);
+        return;
+    }
+    info() << "Slide " << (currentIndex + 1) << "/" << slides.size() << "\n";
     for (const auto& s : shapes) {
         if (s.isImage()) {
-            std::cout << "  - Image '" << s.getName() << "' at (" << s.getX() << "," << s.getY() << ")\n";
+            out() << "  - Image '" << s.getName() << "' at (" << s.getX() << "," << s.getY() << ")\n";
         } else {
-            std::cout << "  - Text '" << s.getName() << "' at (" << s.getX() << "," << s.getY() << ")\n";
+            out() << "  - Text '" << s.getName() << "' at (" << s.getX() << "," << s.getY() << ")\n";
         }
     }
 }
@@ -0,0 +1,250 @@
+#include "Trace.hpp"
+
+#include "Json.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace prof {
+namespace detail {
+std::atomic<bool> g_tracing{false};
+}
+
+namespace {
+
+struct Event
+{
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+constexpr size_t kChunkEvents = 4096;
+constexpr size_t kMaxChunks = 1024;  // ~4M events per thread per trace
+
+struct Chunk
+{
+    Event ev[kChunkEvents];
+    std::atomic<Chunk*> next{nullptr};
+};
+
+// Written only by its thread; read by stopTrace() up to `published`.
+struct ThreadBuffer
+{
+    uint32_t tid = 0;
+    std::string name;                   // guarded by g_mutex
+    std::atomic<bool> alive{true};
+
+    std::unique_ptr<Chunk> head;        // chunks are kept for reuse
+    Chunk* tail = nullptr;              // owner only
+    size_t tailUsed = 0;                // owner only
+    size_t chunks = 0;                  // owner only
+    uint64_t epoch = 0;                 // owner only
+    size_t count = 0;                   // owner only
+
+    std::atomic<uint64_t> publishedEpoch{0};
+    std::atomic<size_t> published{0};
+    std::atomic<size_t> dropped{0};
+
+    ~ThreadBuffer()
+    {
+        Chunk* c = head ? head->next.load(std::memory_order_relaxed) : nullptr;
+        while (c) {
+            Chunk* n = c->next.load(std::memory_order_relaxed);
+            delete c;
+            c = n;
+        }
+    }
+};
+
+std::mutex g_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> g_buffers;
+uint32_t g_nextTid = 1;
+
+std::atomic<uint64_t> g_epoch{0};
+uint64_t g_startNs = 0;      // guarded by g_mutex
+std::string g_path;          // guarded by g_mutex
+
+struct ThreadHolder
+{
+    std::shared_ptr<ThreadBuffer> buf;
+
+    ThreadHolder()
+    {
+        buf = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(g_mutex);
+        buf->tid = g_nextTid++;
+        buf->name = "thread " + std::to_string(buf->tid);
+        g_buffers.push_back(buf);
+    }
+
+    ~ThreadHolder()
+    {
+        buf->alive.store(false, std::memory_order_relaxed);
+        // While a trace runs the events are still needed; stopTrace()
+        // drops the buffer afterwards.
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (!detail::g_tracing.load(std::memory_order_relaxed)) {
+            g_buffers.erase(std::remove(g_buffers.begin(), g_buffers.end(), buf), g_buffers.end());
+        }
+    }
+};
+
+ThreadBuffer& localBuffer()
+{
+    thread_local ThreadHolder holder;
+    return *holder.buf;
+}
+
+void appendEvent(std::string& out, const Event& e, uint32_t tid, uint64_t base)
+{
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                  tid, double(e.start - base) / 1e3, double(e.end - e.start) / 1e3);
+    out += ",\n{\"name\":";
+    json::appendString(out, e.name);
+    out += buf;
+}
+
+} // namespace
+
+void detail::traceEvent(const char* name, uint64_t startNs, uint64_t endNs)
+{
+    ThreadBuffer& b = localBuffer();
+
+    const uint64_t epoch = g_epoch.load(std::memory_order_acquire);
+    if (b.epoch != epoch) {
+        // First event of a new trace on this thread: rewind.
+        if (!b.head) {
+            b.head.reset(new Chunk);
+            b.chunks = 1;
+        }
+        b.tail = b.head.get();
+        b.tailUsed = 0;
+        b.count = 0;
+        b.epoch = epoch;
+        b.published.store(0, std::memory_order_relaxed);
+        b.dropped.store(0, std::memory_order_relaxed);
+        b.publishedEpoch.store(epoch, std::memory_order_release);
+    }
+
+    if (b.tailUsed == kChunkEvents) {
+        Chunk* next = b.tail->next.load(std::memory_order_relaxed);
+        if (!next) {
+            if (b.chunks >= kMaxChunks) {
+                b.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            next = new Chunk;
+            ++b.chunks;
+            b.tail->next.store(next, std::memory_order_release);
+        }
+        b.tail = next;
+        b.tailUsed = 0;
+    }
+
+    b.tail->ev[b.tailUsed++] = Event{name, startNs, endNs};
+    b.published.store(++b.count, std::memory_order_release);
+}
+
+void setThreadName(const std::string& name)
+{
+    ThreadBuffer& b = localBuffer();
+    std::lock_guard<std::mutex> lock(g_mutex);
+    b.name = name;
+}
+
+bool startTrace(const std::string& path, std::string* err)
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (detail::g_tracing.load(std::memory_order_relaxed)) {
+        if (err) *err = "a trace is already running (" + g_path + ")";
+        return false;
+    }
+    {
+        std::ofstream probe(path, std::ios::binary | std::ios::trunc);
+        if (!probe) {
+            if (err) *err = "cannot write " + path;
+            return false;
+        }
+    }
+    g_path = path;
+    g_startNs = nowNs();
+    g_epoch.fetch_add(1, std::memory_order_release);
+    detail::g_tracing.store(true, std::memory_order_release);
+    return true;
+}
+
+bool stopTrace(size_t* events, size_t* dropped, std::string* err)
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!detail::g_tracing.load(std::memory_order_relaxed)) {
+        if (err) *err = "no trace is running";
+        return false;
+    }
+    detail::g_tracing.store(false, std::memory_order_release);
+
+    const uint64_t epoch = g_epoch.load(std::memory_order_relaxed);
+    size_t written = 0;
+    size_t lost = 0;
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                      "\"args\":{\"name\":\"SlideShow\"}}";
+
+    for (const auto& b : g_buffers) {
+        if (b->publishedEpoch.load(std::memory_order_acquire) != epoch) continue;
+        const size_t n = b->published.load(std::memory_order_acquire);
+        lost += b->dropped.load(std::memory_order_relaxed);
+
+        out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(b->tid) +
+               ",\"args\":{\"name\":";
+        json::appendString(out, b->name);
+        out += "}}";
+
+        size_t seen = 0;
+        for (const Chunk* c = b->head.get(); c && seen < n; c = c->next.load(std::memory_order_acquire)) {
+            const size_t take = std::min(kChunkEvents, n - seen);
+            for (size_t i = 0; i < take; ++i) {
+                const Event& e = c->ev[i];
+                // Scopes that began before the trace started are cut off.
+                if (e.start < g_startNs) continue;
+                appendEvent(out, e, b->tid, g_startNs);
+                ++written;
+            }
+            seen += take;
+        }
+    }
+    out += "\n]}\n";
+
+    // Threads that ended during the trace are no longer needed.
+    g_buffers.erase(std::remove_if(g_buffers.begin(), g_buffers.end(),
+                                   [](const auto& b) { return !b->alive.load(std::memory_order_relaxed); }),
+                    g_buffers.end());
+
+    const std::string path = g_path;
+    g_path.clear();
+
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f << out;
+    if (!f) {
+        if (err) *err = "failed to write " + path;
+        return false;
+    }
+    if (events) *events = written;
+    if (dropped) *dropped = lost;
+    return true;
+}
+
+std::string tracePath()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_path;
+}
+
+} // namespace prof
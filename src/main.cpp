@@ -1,7 +1,75 @@
 #include "Controller.hpp"
+#include "RpcServer.hpp"
+#include "Log.hpp"
+#include "Profiler.hpp"
+#include "RecordWriter.hpp"
+#include "Trace.hpp"
+#include <charconv>
 #include <iostream>
+#include <string>
 
-int main() {
+int main(int argc, char** argv) {
+    // --log-level=<info|success|error|quiet> --log-file=<path> --output=<text|json|tsv>
+    // --history=<undo states, 0 = all>
+    size_t history = 0;
+    bool historySet = false;
+    int argi = 1;
+    for (; argi < argc; ++argi) {
+        const std::string a = argv[argi];
+        if (a.rfind("--log-level=", 0) == 0) {
+            logging::Level level;
+            if (!logging::parseLevel(a.substr(12), level)) {
+                std::cerr << "Unknown log level: " << a.substr(12) << " (info, success, error, quiet)\n";
+                return 2;
+            }
+            logging::setMinLevel(level);
+        } else if (a.rfind("--log-file=", 0) == 0) {
+            std::string err;
+            auto sink = logging::fileSink(a.substr(11), &err);
+            if (!sink) {
+                std::cerr << "Cannot log to file: " << err << "\n";
+                return 2;
+            }
+            logging::addSink(std::move(sink), true);
+        } else if (a.rfind("--output=", 0) == 0) {
+            OutputFormat format;
+            if (!parseOutputFormat(a.substr(9), format)) {
+                std::cerr << "Unknown output format: " << a.substr(9) << " (text, json, tsv)\n";
+                return 2;
+            }
+            setOutputFormat(format);
+        } else if (a.rfind("--history=", 0) == 0) {
+            const std::string v = a.substr(10);
+            const char* end = v.data() + v.size();
+            if (v.empty() || std::from_chars(v.data(), end, history).ptr != end) {
+                std::cerr << "Bad history limit: " << v << " (number of undo states, 0 = unlimited)\n";
+                return 2;
+            }
+            historySet = true;
+        } else {
+            break;
+        }
+    }
+
+    if (argi < argc && std::string(argv[argi]) == "--serve") {
+        if (argi + 1 >= argc) {
+            std::cerr << "Usage: SlideShowCLI [--log-level=<level>] [--log-file=<path>] [--history=<n>] --serve <socket>\n";
+            return 2;
+        }
+        prof::setThreadName("rpc server");
+        RpcServer server(argv[argi + 1]);
+        if (historySet) server.setHistoryLimit(history);
+        if (!server.listen()) return 1;
+        server.run();
+        logging::flush();
+        prof::report(std::cerr);
+        return 0;
+    }
+
+    prof::setThreadName("main");
+    Controller::instance().setHistoryLimit(history);
     Controller::instance().run();
+    logging::flush();
+    prof::report(std::cerr);
     return 0;
-}
\ No newline at end of file
+}